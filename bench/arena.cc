@@ -0,0 +1,64 @@
+#include <memory_resource>
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Request whose domain, session ID and credentials are all too long for inline storage.
+ * With an arena, parsing takes nothing from the global heap.
+ */
+
+namespace
+{
+
+const size_t ARENA_SIZE = 1024;
+
+const vector<uint8_t> &message()
+{
+	static const vector<uint8_t> buf = []() {
+		Request req(SOCKS6_REQUEST_CONNECT, Address("a-rather-long-host-name.example.com"), 443);
+		req.options.session.setID(SessionID(SESSION_ID_PREALLOC + 16, 0x5a));
+		req.options.userPassword.setCredentials({ "a-long-enough-username", "and-an-even-longer-password" });
+
+		vector<uint8_t> buf(req.packedSize());
+		req.pack(buf.data(), buf.size());
+		return buf;
+	}();
+	return buf;
+}
+
+}
+
+S6M_BENCH(Arena, DefaultResource)
+{
+	const vector<uint8_t> &msg = message();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		Request req(SOCKS6_REQUEST_NOOP);
+		Request::parse(&bb, &req);
+		Bench::keep(req);
+	}
+}
+
+S6M_BENCH(Arena, MonotonicBuffer)
+{
+	const vector<uint8_t> &msg = message();
+	alignas(max_align_t) uint8_t arena[ARENA_SIZE];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		/* running out throws bad_alloc instead of falling back to the heap */
+		pmr::monotonic_buffer_resource resource(arena, sizeof(arena), pmr::null_memory_resource());
+
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		Request req(SOCKS6_REQUEST_NOOP, Address(), 0, &resource);
+		if (Request::parse(&bb, &req) != PR_SUCCESS)
+			abort();
+		Bench::keep(req);
+	}
+}
@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <vector>
+#include <random>
+#include <unordered_map>
+#include "associationtable.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Association lookups by assocID, 64 per operation (one datagram burst), at 1K to 10M associations:
+ * AssociationTable one at a time, batched, and std::unordered_map for reference.
+ */
+
+namespace
+{
+
+const size_t BURST   = 64;
+const size_t LOOKUPS = 1 << 16;
+
+struct Association
+{
+	uint64_t assocID;
+};
+
+template <size_t N>
+struct Fixture
+{
+	vector<Association> associations;
+	AssociationTable<Association> table;
+	unordered_map<uint64_t, Association *> map;
+	/* in random order, so most lookups miss the cache once the table outgrows it */
+	vector<uint64_t> lookups;
+
+	Fixture()
+		: associations(N), table(N), lookups(LOOKUPS)
+	{
+		AssociationIDGenerator generator(0x5eed);
+		map.reserve(N);
+		for (size_t i = 0; i < N; i++)
+		{
+			associations[i].assocID = table.add(&generator, &associations[i]);
+			if (associations[i].assocID == 0)
+				abort();
+			map[associations[i].assocID] = &associations[i];
+		}
+
+		mt19937_64 random(1);
+		for (uint64_t &id: lookups)
+			id = associations[random() % N].assocID;
+	}
+};
+
+template <size_t N>
+Fixture<N> *fixture()
+{
+	static Fixture<N> fixture;
+	return &fixture;
+}
+
+template <size_t N>
+void find(uint64_t iterations)
+{
+	Fixture<N> *f = fixture<N>();
+	Association *found[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		const uint64_t *ids = &f->lookups[(i * BURST) % LOOKUPS];
+		for (size_t j = 0; j < BURST; j++)
+			found[j] = f->table.find(ids[j]);
+		Bench::keep(found);
+	}
+}
+
+template <size_t N>
+void findBatch(uint64_t iterations)
+{
+	Fixture<N> *f = fixture<N>();
+	Association *found[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		f->table.find(&f->lookups[(i * BURST) % LOOKUPS], BURST, found);
+		Bench::keep(found);
+	}
+}
+
+template <size_t N>
+void unorderedMap(uint64_t iterations)
+{
+	Fixture<N> *f = fixture<N>();
+	Association *found[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		const uint64_t *ids = &f->lookups[(i * BURST) % LOOKUPS];
+		for (size_t j = 0; j < BURST; j++)
+		{
+			auto it = f->map.find(ids[j]);
+			found[j] = it != f->map.end() ? it->second : nullptr;
+		}
+		Bench::keep(found);
+	}
+}
+
+}
+
+#define S6M_BENCH_ASSOCIATIONS(N, SUFFIX) \
+	static Bench::Registration associations_find##SUFFIX        ("Associations", "Find"         #SUFFIX, find<N>); \
+	static Bench::Registration associations_findBatch##SUFFIX   ("Associations", "FindBatch"    #SUFFIX, findBatch<N>); \
+	static Bench::Registration associations_unorderedMap##SUFFIX("Associations", "UnorderedMap" #SUFFIX, unorderedMap<N>);
+
+S6M_BENCH_ASSOCIATIONS(1000,     1K)
+S6M_BENCH_ASSOCIATIONS(10000,    10K)
+S6M_BENCH_ASSOCIATIONS(100000,   100K)
+S6M_BENCH_ASSOCIATIONS(1000000,  1M)
+S6M_BENCH_ASSOCIATIONS(10000000, 10M)
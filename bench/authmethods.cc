@@ -0,0 +1,73 @@
+#include <set>
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * A server picking a method out of a client's advertisement.
+ */
+
+namespace
+{
+
+const vector<uint8_t> &message()
+{
+	static const vector<uint8_t> buf = []() {
+		Request req(SOCKS6_REQUEST_CONNECT, Address("example.com"), 443);
+		req.options.authMethods.advertise({ SOCKS6_METHOD_GSSAPI, SOCKS6_METHOD_USRPASSWD, SOCKS6_METHOD_SSL, (SOCKS6Method)0x80 }, 0);
+
+		vector<uint8_t> buf(req.packedSize());
+		req.pack(buf.data(), buf.size());
+		return buf;
+	}();
+	return buf;
+}
+
+}
+
+S6M_BENCH(AuthMethods, SetIntersection)
+{
+	const vector<uint8_t> &msg = message();
+	const set<SOCKS6Method> policy = { SOCKS6_METHOD_USRPASSWD, SOCKS6_METHOD_SSL };
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		RequestView req;
+		RequestView::parse(&bb, &req);
+
+		set<SOCKS6Method> offered;
+		for (uint8_t method: req.options.authMethods.getAdvertised())
+			offered.insert((SOCKS6Method)method);
+
+		SOCKS6Method selected = SOCKS6_METHOD_UNACCEPTABLE;
+		for (SOCKS6Method method: offered)
+		{
+			if (policy.find(method) != policy.end())
+			{
+				selected = method;
+				break;
+			}
+		}
+		Bench::keep(selected);
+	}
+}
+
+S6M_BENCH(AuthMethods, MaskIntersection)
+{
+	const vector<uint8_t> &msg = message();
+	const AuthMethodMask policy = { SOCKS6_METHOD_USRPASSWD, SOCKS6_METHOD_SSL };
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		RequestView req;
+		RequestView::parse(&bb, &req);
+
+		SOCKS6Method selected = (AuthMethodMask(req.options.authMethods.getAdvertised()) & policy).first();
+		Bench::keep(selected);
+	}
+}
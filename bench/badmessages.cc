@@ -0,0 +1,213 @@
+#include <arpa/inet.h>
+#include <string.h>
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Corpus of malformed or truncated messages, as seen on hostile or lossy links.
+ */
+
+namespace
+{
+
+enum MessageType
+{
+	T_REQUEST,
+	T_AUTH_REPLY,
+	T_OP_REPLY,
+};
+
+struct BadMessage
+{
+	MessageType     type;
+	vector<uint8_t> buf;
+};
+
+vector<uint8_t> packRequest(const Request &req)
+{
+	vector<uint8_t> buf(req.packedSize());
+	req.pack(buf.data(), buf.size());
+	return buf;
+}
+
+/* IPv4 request followed by count raw options of the given kind and length */
+vector<uint8_t> requestWithOptions(uint16_t kind, uint16_t len, int count)
+{
+	Request req(SOCKS6_REQUEST_CONNECT, Address(in_addr { htonl(0x7f000001) }), 80);
+	vector<uint8_t> buf = packRequest(req);
+	size_t optsOffset = buf.size();
+
+	for (int i = 0; i < count; i++)
+	{
+		size_t offset = buf.size();
+		buf.resize(offset + (len > sizeof(SOCKS6Option) ? len : sizeof(SOCKS6Option)));
+
+		SOCKS6Option *opt = reinterpret_cast<SOCKS6Option *>(&buf[offset]);
+		opt->kind = htons(kind);
+		opt->len  = htons(len);
+	}
+
+	SOCKS6Request *rawRequest = reinterpret_cast<SOCKS6Request *>(buf.data());
+	rawRequest->optionsLength = htons(buf.size() - optsOffset);
+	return buf;
+}
+
+vector<BadMessage> buildCorpus()
+{
+	vector<BadMessage> corpus;
+
+	Request good(SOCKS6_REQUEST_CONNECT, Address("example.com"), 443);
+	good.options.session.request();
+	good.options.idempotence.request(100);
+	vector<uint8_t> goodBuf = packRequest(good);
+
+	/* truncated header */
+	corpus.push_back({ T_REQUEST, vector<uint8_t>(goodBuf.begin(), goodBuf.begin() + 5) });
+
+	/* truncated domain */
+	corpus.push_back({ T_REQUEST, vector<uint8_t>(goodBuf.begin(), goodBuf.begin() + 12) });
+
+	/* truncated options */
+	corpus.push_back({ T_REQUEST, vector<uint8_t>(goodBuf.begin(), goodBuf.end() - 4) });
+
+	/* other version */
+	{
+		vector<uint8_t> buf = goodBuf;
+		buf[0] = 5;
+		corpus.push_back({ T_REQUEST, buf });
+	}
+
+	/* bad address type */
+	{
+		vector<uint8_t> buf = goodBuf;
+		reinterpret_cast<SOCKS6Request *>(buf.data())->addressType = 2;
+		corpus.push_back({ T_REQUEST, buf });
+	}
+
+	/* empty domain */
+	{
+		vector<uint8_t> buf = goodBuf;
+		reinterpret_cast<SOCKS6Request *>(buf.data())->address[0] = 0;
+		corpus.push_back({ T_REQUEST, buf });
+	}
+
+	/* misaligned options length */
+	{
+		vector<uint8_t> buf = goodBuf;
+		reinterpret_cast<SOCKS6Request *>(buf.data())->optionsLength = htons(3);
+		corpus.push_back({ T_REQUEST, buf });
+	}
+
+	/* unknown options; the message itself parses */
+	corpus.push_back({ T_REQUEST, requestWithOptions(SOCKS6_OPTION_VENDOR_MIN, 4, 32) });
+
+	/* truncated stack options */
+	corpus.push_back({ T_REQUEST, requestWithOptions(SOCKS6_OPTION_STACK, 4, 32) });
+
+	/* options not allowed in requests */
+	corpus.push_back({ T_REQUEST, requestWithOptions(SOCKS6_OPTION_SESSION_OK, 4, 32) });
+
+	/* bad authentication reply code */
+	{
+		AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+		vector<uint8_t> buf(authReply.packedSize());
+		authReply.pack(buf.data(), buf.size());
+		reinterpret_cast<SOCKS6AuthReply *>(buf.data())->type = 7;
+		corpus.push_back({ T_AUTH_REPLY, buf });
+	}
+
+	/* truncated bind address */
+	{
+		OperationReply opReply(SOCKS6_OPERATION_REPLY_SUCCESS, Address(in6addr_loopback), 1080);
+		vector<uint8_t> buf(opReply.packedSize());
+		opReply.pack(buf.data(), buf.size());
+		buf.resize(sizeof(SOCKS6OperationReply) + 8);
+		corpus.push_back({ T_OP_REPLY, buf });
+	}
+
+	return corpus;
+}
+
+const vector<BadMessage> &corpus()
+{
+	static const vector<BadMessage> corpus = buildCorpus();
+	return corpus;
+}
+
+}
+
+S6M_BENCH(BadMessages, Exceptions)
+{
+	const vector<BadMessage> &msgs = corpus();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		const BadMessage &msg = msgs[i % msgs.size()];
+		ByteBuffer bb(const_cast<uint8_t *>(msg.buf.data()), msg.buf.size());
+
+		try
+		{
+			switch (msg.type)
+			{
+			case T_REQUEST:
+			{
+				Request req(&bb);
+				Bench::keep(req);
+				break;
+			}
+			case T_AUTH_REPLY:
+			{
+				AuthenticationReply authReply(&bb);
+				Bench::keep(authReply);
+				break;
+			}
+			case T_OP_REPLY:
+			{
+				OperationReply opReply(&bb);
+				Bench::keep(opReply);
+				break;
+			}
+			}
+		}
+		catch (exception &) {}
+	}
+}
+
+S6M_BENCH(BadMessages, ParseResult)
+{
+	const vector<BadMessage> &msgs = corpus();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		const BadMessage &msg = msgs[i % msgs.size()];
+		ByteBuffer bb(const_cast<uint8_t *>(msg.buf.data()), msg.buf.size());
+		ParseResult result = PR_SUCCESS;
+
+		switch (msg.type)
+		{
+		case T_REQUEST:
+		{
+			Request req(SOCKS6_REQUEST_NOOP);
+			result = Request::parse(&bb, &req);
+			break;
+		}
+		case T_AUTH_REPLY:
+		{
+			AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+			result = AuthenticationReply::parse(&bb, &authReply);
+			break;
+		}
+		case T_OP_REPLY:
+		{
+			OperationReply opReply(SOCKS6_OPERATION_REPLY_SUCCESS);
+			result = OperationReply::parse(&bb, &opReply);
+			break;
+		}
+		}
+		Bench::keep(result);
+	}
+}
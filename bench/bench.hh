@@ -0,0 +1,32 @@
+#ifndef SOCKS6MSG_BENCH_HH
+#define SOCKS6MSG_BENCH_HH
+
+#include <stdint.h>
+#include <unistd.h>
+
+namespace Bench
+{
+
+/* runs the measured operation iterations times */
+typedef void (*Function)(uint64_t iterations);
+
+struct Registration
+{
+	Registration(const char *group, const char *name, Function function);
+};
+
+/* keeps the compiler from optimizing away a result */
+template <typename T>
+inline void keep(T &&value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+}
+
+#define S6M_BENCH(GROUP, NAME) \
+	static void GROUP##_##NAME(uint64_t iterations); \
+	static Bench::Registration GROUP##_##NAME##_registration(#GROUP, #NAME, GROUP##_##NAME); \
+	static void GROUP##_##NAME(uint64_t iterations)
+
+#endif // SOCKS6MSG_BENCH_HH
@@ -0,0 +1,39 @@
+TARGET = socks6msg-bench
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle
+CONFIG -= qt
+
+INCLUDEPATH += .. ../fields ../messages ../options ../util
+
+# tags the results, so they can be told apart across versions
+REVISION = $$system(git -C $$PWD describe --always --dirty 2>/dev/null)
+!isEmpty(REVISION): DEFINES += S6M_BENCH_REVISION=\\\"$$REVISION\\\"
+
+LIBS += -L.. -lsocks6msg
+PRE_TARGETDEPS += ../libsocks6msg.a
+
+SOURCES += \
+    main.cc \
+    badmessages.cc \
+    stream.cc \
+    dispatch.cc \
+    pack.cc \
+    views.cc \
+    authmethods.cc \
+    arena.cc \
+    messages.cc \
+    datagrambatch.cc \
+    encapsulation.cc \
+    datagramprefix.cc \
+    associations.cc \
+    gather.cc \
+    scatter.cc \
+    prepacked.cc \
+    worstcase.cc \
+    idempotence.cc \
+    tokenallocator.cc \
+    sessiontable.cc
+
+HEADERS += \
+    bench.hh
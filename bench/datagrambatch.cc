@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <vector>
+#include "datagrambatch.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * A 64-datagram UDP burst, as handed over by recvmmsg() or to sendmmsg():
+ * header by header with DatagramHeader versus DatagramBatch in one call.
+ * Mostly IPv4 peers, with some IPv6 and domain ones mixed in.
+ */
+
+namespace
+{
+
+const size_t BURST        = DatagramBatch::MAX;
+const size_t PAYLOAD_SIZE = 512;
+const size_t HEADER_ROOM  = 64;
+
+DatagramHeader sampleHeader(size_t i)
+{
+	uint64_t assocID = 0x0123456789abcdef + i;
+	uint16_t port    = 1024 + i;
+
+	if (i % 8 == 3)
+		return DatagramHeader(assocID, Address(in6addr_loopback), port);
+	if (i % 16 == 7)
+		return DatagramHeader(assocID, Address("dns.example"), port);
+	return DatagramHeader(assocID, Address(in_addr { htonl(0x0a000000 + i) }), port);
+}
+
+struct Burst
+{
+	vector<vector<uint8_t>> datagrams;
+	vector<iovec>           iovs;
+	vector<mmsghdr>         msgs;
+
+	Burst()
+		: datagrams(BURST), iovs(BURST), msgs(BURST)
+	{
+		for (size_t i = 0; i < BURST; i++)
+		{
+			DatagramHeader header = sampleHeader(i);
+			datagrams[i].resize(header.packedSize() + PAYLOAD_SIZE, 0xa5);
+			header.pack(datagrams[i].data(), datagrams[i].size());
+
+			iovs[i] = { datagrams[i].data(), datagrams[i].size() };
+			msgs[i] = {};
+			msgs[i].msg_hdr.msg_iov    = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_len            = datagrams[i].size();
+		}
+	}
+};
+
+Burst *burst()
+{
+	static Burst burst;
+	return &burst;
+}
+
+/* header room plus payload, the way sendmmsg() gets it */
+struct OutBurst
+{
+	vector<uint8_t> headers;
+	vector<uint8_t> payload;
+	vector<iovec>   iovs;
+	vector<mmsghdr> msgs;
+
+	OutBurst()
+		: headers(BURST * HEADER_ROOM), payload(PAYLOAD_SIZE, 0xa5), iovs(BURST * 2), msgs(BURST)
+	{
+		for (size_t i = 0; i < BURST; i++)
+		{
+			msgs[i] = {};
+			msgs[i].msg_hdr.msg_iov    = &iovs[i * 2];
+			msgs[i].msg_hdr.msg_iovlen = 2;
+		}
+	}
+
+	void reset()
+	{
+		for (size_t i = 0; i < BURST; i++)
+		{
+			iovs[i * 2]     = { headers.data() + i * HEADER_ROOM, HEADER_ROOM };
+			iovs[i * 2 + 1] = { payload.data(), payload.size() };
+		}
+	}
+};
+
+}
+
+S6M_BENCH(DatagramBatch, ParseLoop)
+{
+	Burst *in = burst();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+		{
+			ByteBuffer bb(in->datagrams[j].data(), in->msgs[j].msg_len);
+			DatagramHeader header((uint64_t)0);
+			if (DatagramHeader::parse(&bb, &header) != PR_SUCCESS)
+				abort();
+			Bench::keep(header);
+		}
+	}
+}
+
+S6M_BENCH(DatagramBatch, ParseBatch)
+{
+	Burst *in = burst();
+	DatagramBatch batch;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		if (batch.parse(in->msgs.data(), BURST) != BURST)
+			abort();
+		Bench::keep(batch);
+	}
+}
+
+S6M_BENCH(DatagramBatch, PackLoop)
+{
+	vector<DatagramHeader> headers;
+	for (size_t j = 0; j < BURST; j++)
+		headers.push_back(sampleHeader(j));
+	OutBurst out;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		out.reset();
+		for (size_t j = 0; j < BURST; j++)
+		{
+			iovec *iov = &out.iovs[j * 2];
+			iov->iov_len = headers[j].pack(reinterpret_cast<uint8_t *>(iov->iov_base), iov->iov_len);
+		}
+		Bench::keep(out.headers);
+	}
+}
+
+S6M_BENCH(DatagramBatch, PackBatch)
+{
+	vector<DatagramHeader> headers;
+	for (size_t j = 0; j < BURST; j++)
+		headers.push_back(sampleHeader(j));
+	DatagramBatch batch;
+	batch.count = BURST;
+	for (size_t j = 0; j < BURST; j++)
+	{
+		batch.assocID[j] = headers[j].assocID;
+		batch.address[j] = headers[j].address;
+		batch.port[j]    = headers[j].port;
+	}
+	OutBurst out;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		out.reset();
+		if (batch.pack(out.msgs.data()) != BURST)
+			abort();
+		Bench::keep(out.headers);
+	}
+}
@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "datagramprefix.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Datagrams to a domain destination: the header packed every time versus packed once and copied.
+ * Then a 64-segment GSO super-packet, built by copying versus laid out over iovecs.
+ */
+
+namespace
+{
+
+const size_t SEGMENTS        = 64;
+const size_t SEGMENT_PAYLOAD = 1200;
+
+const DatagramHeader &header()
+{
+	static const DatagramHeader header(0x0123456789abcdef, Address("resolver.example.com"), 53);
+	return header;
+}
+
+}
+
+S6M_BENCH(DatagramPrefix, Header)
+{
+	uint8_t buf[DatagramHeader::MAX_HEADROOM];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		header().pack(buf, sizeof(buf));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(DatagramPrefix, Prefix)
+{
+	DatagramPrefix prefix(header());
+	uint8_t buf[DatagramHeader::MAX_HEADROOM];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		prefix.pack(buf, sizeof(buf));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(DatagramPrefix, SuperPacketCopy)
+{
+	vector<uint8_t> payload(SEGMENTS * SEGMENT_PAYLOAD, 0xa5);
+	vector<uint8_t> superPacket(SEGMENTS * (DatagramHeader::MAX_HEADROOM + SEGMENT_PAYLOAD));
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		size_t offset = 0;
+		for (size_t j = 0; j < SEGMENTS; j++)
+		{
+			offset += header().pack(superPacket.data() + offset, superPacket.size() - offset);
+			memcpy(superPacket.data() + offset, payload.data() + j * SEGMENT_PAYLOAD, SEGMENT_PAYLOAD);
+			offset += SEGMENT_PAYLOAD;
+		}
+		Bench::keep(superPacket);
+	}
+}
+
+S6M_BENCH(DatagramPrefix, SuperPacketGather)
+{
+	DatagramPrefix prefix(header());
+	vector<uint8_t> payload(SEGMENTS * SEGMENT_PAYLOAD, 0xa5);
+	iovec iovs[SEGMENTS * 2];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		if (prefix.gather(payload.data(), payload.size(), SEGMENT_PAYLOAD, iovs, SEGMENTS * 2) != SEGMENTS * 2)
+			abort();
+		Bench::keep(iovs);
+	}
+}
@@ -0,0 +1,103 @@
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Requests made mostly of options, to weigh per-option dispatch.
+ */
+
+namespace
+{
+
+vector<uint8_t> pack(const Request &req)
+{
+	vector<uint8_t> buf(req.packedSize());
+	req.pack(buf.data(), buf.size());
+	return buf;
+}
+
+/* one of every option a request may carry */
+const vector<uint8_t> &known()
+{
+	static const vector<uint8_t> buf = []() {
+		Request req(SOCKS6_REQUEST_CONNECT, Address(in_addr { htonl(0x7f000001) }), 80);
+		req.options.stack.tos.set(SOCKS6_STACK_LEG_CLIENT_PROXY, 0x10);
+		req.options.stack.tos.set(SOCKS6_STACK_LEG_PROXY_REMOTE, 0x20);
+		req.options.stack.tfo.set(SOCKS6_STACK_LEG_PROXY_REMOTE, 1000);
+		req.options.stack.mp.set(SOCKS6_STACK_LEG_PROXY_REMOTE, SOCKS6_MP_AVAILABLE);
+		req.options.stack.backlog.set(SOCKS6_STACK_LEG_PROXY_REMOTE, 10);
+		req.options.session.setID(SessionID(16, 0x5a));
+		req.options.session.setUntrusted();
+		req.options.idempotence.request(100);
+		req.options.idempotence.setToken(1234);
+		req.options.authMethods.advertise({ SOCKS6_METHOD_USRPASSWD }, 0);
+		return pack(req);
+	}();
+	return buf;
+}
+
+/* many stack options that all get dropped as duplicates */
+const vector<uint8_t> &duplicates()
+{
+	static const vector<uint8_t> buf = []() {
+		Request req(SOCKS6_REQUEST_CONNECT, Address(in_addr { htonl(0x7f000001) }), 80);
+		req.options.stack.tos.set(SOCKS6_STACK_LEG_BOTH, 0x10);
+		vector<uint8_t> buf = pack(req);
+
+		size_t optsOffset = buf.size() - sizeof(SOCKS6TOSOption);
+		vector<uint8_t> opt(buf.begin() + optsOffset, buf.end());
+		for (int i = 0; i < 255; i++)
+			buf.insert(buf.end(), opt.begin(), opt.end());
+
+		reinterpret_cast<SOCKS6Request *>(buf.data())->optionsLength = htons(buf.size() - optsOffset);
+		return buf;
+	}();
+	return buf;
+}
+
+void parse(const vector<uint8_t> &msg, uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		Request req(SOCKS6_REQUEST_NOOP);
+		Request::parse(&bb, &req);
+		Bench::keep(req);
+	}
+}
+
+void parseView(const vector<uint8_t> &msg, uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		RequestView req;
+		RequestView::parse(&bb, &req);
+		Bench::keep(req);
+	}
+}
+
+}
+
+S6M_BENCH(Dispatch, KnownOptions)
+{
+	parse(known(), iterations);
+}
+
+S6M_BENCH(Dispatch, KnownOptionsView)
+{
+	parseView(known(), iterations);
+}
+
+S6M_BENCH(Dispatch, DuplicateStackOptions)
+{
+	parse(duplicates(), iterations);
+}
+
+S6M_BENCH(Dispatch, DuplicateStackOptionsView)
+{
+	parseView(duplicates(), iterations);
+}
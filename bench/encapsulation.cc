@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "datagramheader.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Relaying one 1400-byte UDP payload to the client: packing the header and copying the payload behind it,
+ * versus packing the header into headroom left in front of the payload.
+ */
+
+namespace
+{
+
+const size_t PAYLOAD_SIZE = 1400;
+
+const DatagramHeader &header()
+{
+	static const DatagramHeader header(0x0123456789abcdef, Address(in_addr { htonl(0x0a000001) }), 53);
+	return header;
+}
+
+}
+
+S6M_BENCH(Encapsulation, CopyPayload)
+{
+	vector<uint8_t> payload(PAYLOAD_SIZE, 0xa5);
+	vector<uint8_t> datagram(DatagramHeader::MAX_HEADROOM + PAYLOAD_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		size_t headerSize = header().pack(datagram.data(), datagram.size());
+		memcpy(datagram.data() + headerSize, payload.data(), payload.size());
+		Bench::keep(datagram);
+	}
+}
+
+S6M_BENCH(Encapsulation, Headroom)
+{
+	/* received straight after the headroom */
+	vector<uint8_t> buf(DatagramHeader::MAX_HEADROOM + PAYLOAD_SIZE, 0xa5);
+	uint8_t *payload = buf.data() + DatagramHeader::MAX_HEADROOM;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		uint8_t *datagram = header().encapsulate(payload, DatagramHeader::MAX_HEADROOM);
+		Bench::keep(datagram);
+	}
+}
+
+S6M_BENCH(Encapsulation, CopyOut)
+{
+	vector<uint8_t> datagram(header().packedSize() + PAYLOAD_SIZE, 0xa5);
+	header().pack(datagram.data(), datagram.size());
+	vector<uint8_t> payload(PAYLOAD_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(datagram.data(), datagram.size());
+		DatagramHeader parsed((uint64_t)0);
+		if (DatagramHeader::parse(&bb, &parsed) != PR_SUCCESS)
+			abort();
+		memcpy(payload.data(), datagram.data() + bb.getUsed(), datagram.size() - bb.getUsed());
+		Bench::keep(payload);
+	}
+}
+
+S6M_BENCH(Encapsulation, Decapsulate)
+{
+	vector<uint8_t> datagram(header().packedSize() + PAYLOAD_SIZE, 0xa5);
+	header().pack(datagram.data(), datagram.size());
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		DatagramHeader parsed((uint64_t)0);
+		size_t payloadOffset;
+		if (DatagramHeader::decapsulate(datagram.data(), datagram.size(), &parsed, &payloadOffset) != PR_SUCCESS)
+			abort();
+		Bench::keep(payloadOffset);
+	}
+}
@@ -0,0 +1,63 @@
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Replies carrying a large session ID: packed into one buffer versus into an iovec list that references the ID.
+ */
+
+namespace
+{
+
+const size_t BUF_SIZE = SOCKS6_OPTIONS_LENGTH_MAX + 1024;
+const size_t SCRATCH_SIZE = 512;
+const size_t IOVECS = 8;
+
+void fill(OptionSet *options, size_t idSize)
+{
+	options->session.setID(SessionID(idSize, 0x5a));
+	options->idempotence.advertise({ 1000, 100 });
+}
+
+template <size_t ID_SIZE>
+void pack(uint64_t iterations)
+{
+	AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+	fill(&authReply.options, ID_SIZE);
+	vector<uint8_t> out(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		authReply.pack(out.data(), out.size());
+		Bench::keep(out);
+	}
+}
+
+template <size_t ID_SIZE>
+void gatherPack(uint64_t iterations)
+{
+	AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+	fill(&authReply.options, ID_SIZE);
+	uint8_t scratch[SCRATCH_SIZE];
+	iovec iovs[IOVECS];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		GatherBuffer gb(scratch, sizeof(scratch), iovs, IOVECS);
+		authReply.pack(&gb);
+		Bench::keep(gb.finish());
+		Bench::keep(scratch);
+	}
+}
+
+}
+
+static Bench::Registration gather_pack16   ("Gather", "Pack16",        pack<16>);
+static Bench::Registration gather_gather16 ("Gather", "GatherPack16",  gatherPack<16>);
+static Bench::Registration gather_pack1K   ("Gather", "Pack1K",        pack<1024>);
+static Bench::Registration gather_gather1K ("Gather", "GatherPack1K",  gatherPack<1024>);
+static Bench::Registration gather_pack16K  ("Gather", "Pack16K",       pack<SOCKS6_OPTIONS_LENGTH_MAX - 64>);
+static Bench::Registration gather_gather16K("Gather", "GatherPack16K", gatherPack<SOCKS6_OPTIONS_LENGTH_MAX - 64>);
@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <set>
+#include <random>
+#include <thread>
+#include <vector>
+#include "idempotencewindow.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Token spends against a window of SOCKS6_TOKEN_WINDOW_MAX tokens: in order, at random, already spent,
+ * and in order with the window sliding along; std::set for reference.
+ */
+
+namespace
+{
+
+const size_t BURST = 64;
+const uint32_t SPENDS = 1 << 20;
+
+struct Fixture
+{
+	IdempotenceWindow window { { 0, SOCKS6_TOKEN_WINDOW_MAX } };
+	vector<uint32_t> random;
+
+	Fixture()
+		: random(SPENDS)
+	{
+		check();
+
+		mt19937 generator(1);
+		for (uint32_t &token: random)
+			token = generator() % SOCKS6_TOKEN_WINDOW_MAX;
+	}
+
+	static void check()
+	{
+		IdempotenceWindow w({ 100, 64 });
+		if (w.spend(99) || w.spend(164) || !w.spend(100) || w.spend(100) || !w.spend(163))
+			abort();
+
+		/* the old lap's bits must not leak into the new one */
+		if (!w.slide({ 100 + 128, 64 }) || w.spend(163) || !w.spend(163 + 128) || w.isSpent(100 + 128))
+			abort();
+		if (w.slide({ 100, 64 }) || w.slide({ 1000, 1 << 20 }))
+			abort();
+
+		/* across the wrap-around */
+		IdempotenceWindow wrap({ UINT32_MAX - 10, 64 });
+		if (!wrap.spend(UINT32_MAX) || !wrap.spend(5) || wrap.spend(5) || wrap.spend(60))
+			abort();
+
+		/* racing spends: each token goes to exactly one thread */
+		IdempotenceWindow shared({ 0, 1 << 16 });
+		vector<uint32_t> wins(4);
+		vector<thread> threads;
+		for (size_t t = 0; t < wins.size(); t++)
+		{
+			threads.emplace_back([&shared, &wins, t]() {
+				for (uint32_t token = 0; token < 1 << 16; token++)
+					wins[t] += shared.spend(token);
+			});
+		}
+		for (thread &th: threads)
+			th.join();
+		uint32_t total = 0;
+		for (uint32_t w: wins)
+			total += w;
+		if (total != 1 << 16)
+			abort();
+
+		IdempotenceTracker tracker;
+		tracker.open("session", { 0, 16 });
+		if (!tracker.find("session")->spend(1) || tracker.find("session")->spend(1) || tracker.find("other"))
+			abort();
+		tracker.close("session");
+		if (tracker.find("session") || tracker.size() != 0)
+			abort();
+	}
+};
+
+Fixture *fixture()
+{
+	static Fixture fixture;
+	return &fixture;
+}
+
+S6M_BENCH(Idempotence, SpendSequential)
+{
+	Fixture *f = fixture();
+	static uint32_t next = 0;
+	bool spent[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+			spent[j] = f->window.spend(next++ % SOCKS6_TOKEN_WINDOW_MAX);
+		Bench::keep(spent);
+	}
+}
+
+S6M_BENCH(Idempotence, SpendRandom)
+{
+	Fixture *f = fixture();
+	bool spent[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		const uint32_t *tokens = &f->random[(i * BURST) % SPENDS];
+		for (size_t j = 0; j < BURST; j++)
+			spent[j] = f->window.spend(tokens[j]);
+		Bench::keep(spent);
+	}
+}
+
+/* replays: every token has been spent before */
+S6M_BENCH(Idempotence, SpendDuplicate)
+{
+	Fixture *f = fixture();
+	bool spent[BURST];
+
+	for (size_t j = 0; j < BURST; j++)
+		f->window.spend(j);
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+			spent[j] = f->window.spend(j);
+		Bench::keep(spent);
+	}
+}
+
+/* a client that keeps spending at the front of the window, while the server slides it along after every burst */
+S6M_BENCH(Idempotence, SpendSliding)
+{
+	static IdempotenceWindow window({ 0, SOCKS6_TOKEN_WINDOW_MAX });
+	static uint32_t base = 0;
+	bool spent[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+			spent[j] = window.spend(base + j);
+		base += BURST;
+		window.slide({ base, SOCKS6_TOKEN_WINDOW_MAX });
+		Bench::keep(spent);
+	}
+}
+
+S6M_BENCH(Idempotence, StdSetSliding)
+{
+	static set<uint32_t> spentSet;
+	static uint32_t base = 0;
+	bool spent[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+			spent[j] = spentSet.insert(base + j).second;
+		base += BURST;
+		spentSet.erase(spentSet.begin(), spentSet.lower_bound(base));
+		Bench::keep(spent);
+	}
+}
+
+}
@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <new>
+#include <vector>
+#include "socks6.h"
+#include "bench.hh"
+
+using namespace std;
+
+#ifndef S6M_BENCH_REVISION
+#define S6M_BENCH_REVISION "unknown"
+#endif
+
+/*
+ * Allocation counting
+ */
+
+static atomic<uint64_t> allocCount(0);
+
+void *operator new(size_t size)
+{
+	allocCount.fetch_add(1, memory_order_relaxed);
+
+	void *ptr = malloc(size > 0 ? size : 1);
+	if (!ptr)
+		throw bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+/* std::pmr::new_delete_resource() comes through here */
+void *operator new(size_t size, align_val_t align)
+{
+	allocCount.fetch_add(1, memory_order_relaxed);
+
+	void *ptr = aligned_alloc((size_t)align, (size + (size_t)align - 1) / (size_t)align * (size_t)align);
+	if (!ptr)
+		throw bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t size, align_val_t align)
+{
+	return operator new(size, align);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, align_val_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr, align_val_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t, align_val_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, align_val_t) noexcept
+{
+	free(ptr);
+}
+
+/*
+ * Registry
+ */
+
+namespace Bench
+{
+
+struct Entry
+{
+	const char *group;
+	const char *name;
+	Function    function;
+};
+
+static vector<Entry> *registry()
+{
+	static vector<Entry> entries;
+	return &entries;
+}
+
+Registration::Registration(const char *group, const char *name, Function function)
+{
+	registry()->push_back({ group, name, function });
+}
+
+}
+
+/*
+ * Runner
+ */
+
+static double now()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *self)
+{
+	fprintf(stderr, "Usage: %s [-t min_seconds] [filter...]\n", self);
+	fprintf(stderr, "Prints one JSON object per benchmark.\n");
+}
+
+static bool selected(const Bench::Entry &entry, char **filters, int filterCount)
+{
+	if (filterCount == 0)
+		return true;
+
+	char fullName[256];
+	snprintf(fullName, sizeof(fullName), "%s/%s", entry.group, entry.name);
+	for (int i = 0; i < filterCount; i++)
+	{
+		if (strstr(fullName, filters[i]))
+			return true;
+	}
+	return false;
+}
+
+int main(int argc, char **argv)
+{
+	double minTime = 0.5;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 't':
+			minTime = atof(optarg);
+			break;
+
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	for (const Bench::Entry &entry: *Bench::registry())
+	{
+		if (!selected(entry, argv + optind, argc - optind))
+			continue;
+
+		/* fixtures are built on the first call; keep that out of the measurements */
+		entry.function(0);
+		
+		/* warm up and calibrate */
+		uint64_t iterations = 1;
+		double elapsed = 0;
+		while (true)
+		{
+			double start = now();
+			entry.function(iterations);
+			elapsed = now() - start;
+
+			if (elapsed >= minTime / 10)
+				break;
+			iterations *= 2;
+		}
+		if (elapsed < minTime)
+			iterations = iterations * (minTime / elapsed);
+
+		uint64_t allocsBefore = allocCount.load(memory_order_relaxed);
+		double start = now();
+		entry.function(iterations);
+		elapsed = now() - start;
+		uint64_t allocs = allocCount.load(memory_order_relaxed) - allocsBefore;
+
+		printf("{\"benchmark\": \"%s/%s\", \"version\": %d, \"revision\": \"%s\", \"iterations\": %lu, "
+			"\"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"allocs_per_op\": %.3f}\n",
+			entry.group, entry.name, SOCKS6_VERSION, S6M_BENCH_REVISION, (unsigned long)iterations,
+			elapsed * 1e9 / iterations, iterations / elapsed, (double)allocs / iterations);
+		fflush(stdout);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+#include <stdlib.h>
+#include <vector>
+#include "socks6msg.h"
+#include "socks6msg.hh"
+#include "datagramheader.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Parse and pack for every message type, through both the C++ API and the C bindings.
+ * Messages that carry options are measured with several option mixes.
+ */
+
+namespace
+{
+
+const size_t BUF_SIZE = SOCKS6_OPTIONS_LENGTH_MAX + 1024;
+
+enum Mix
+{
+	NO_OPTIONS,
+	STACK,
+	SESSION_IDEMPOTENCE,
+	USER_PASSWORD,
+	/* the above, with a session ID filling the options block up to SOCKS6_OPTIONS_LENGTH_MAX */
+	FULL,
+};
+
+const size_t SESSION_ID_SIZE = 16;
+
+void fillSessionID(OptionSet *options)
+{
+	size_t left = SOCKS6_OPTIONS_LENGTH_MAX - options->packedSize();
+	options->session.setID(SessionID(left - sizeof(SOCKS6SessionIDOption), 0x5a));
+}
+
+void fillRequestOptions(OptionSet *options, Mix mix)
+{
+	if (mix == STACK || mix == FULL)
+	{
+		options->stack.tos.set(SOCKS6_STACK_LEG_CLIENT_PROXY, 0x10);
+		options->stack.tos.set(SOCKS6_STACK_LEG_PROXY_REMOTE, 0x20);
+		options->stack.tfo.set(1024);
+		options->stack.mp.set(SOCKS6_MP_AVAILABLE);
+		options->stack.backlog.set(128);
+	}
+	if (mix == SESSION_IDEMPOTENCE)
+		options->session.setID(SessionID(SESSION_ID_SIZE, 0x5a));
+	if (mix == SESSION_IDEMPOTENCE || mix == FULL)
+		options->idempotence.setToken(1234);
+	if (mix == USER_PASSWORD || mix == FULL)
+	{
+		options->authMethods.advertise({ SOCKS6_METHOD_USRPASSWD }, 0);
+		options->userPassword.setCredentials({ "user", "password" });
+	}
+	if (mix == FULL)
+		fillSessionID(options);
+}
+
+void fillAuthReplyOptions(OptionSet *options, Mix mix)
+{
+	if (mix == STACK || mix == FULL)
+	{
+		options->stack.tos.set(SOCKS6_STACK_LEG_CLIENT_PROXY, 0x10);
+		options->stack.tfo.set(1);
+	}
+	if (mix == SESSION_IDEMPOTENCE)
+		options->session.setID(SessionID(SESSION_ID_SIZE, 0x5a));
+	if (mix == SESSION_IDEMPOTENCE || mix == FULL)
+	{
+		options->idempotence.advertise({ 1000, 100 });
+		options->idempotence.setReply(true);
+	}
+	if (mix == USER_PASSWORD || mix == FULL)
+	{
+		options->authMethods.select(SOCKS6_METHOD_USRPASSWD);
+		options->userPassword.setReply(true);
+	}
+	if (mix == FULL)
+		fillSessionID(options);
+}
+
+template <typename MSG>
+vector<uint8_t> packToVector(const MSG &msg)
+{
+	vector<uint8_t> buf(msg.packedSize());
+	msg.pack(buf.data(), buf.size());
+	return buf;
+}
+
+/* blank(): something to parse into; sample(mix): wire format */
+template <typename MSG>
+struct Traits;
+
+template <>
+struct Traits<Request>
+{
+	static Request blank()
+	{
+		return Request(SOCKS6_REQUEST_NOOP);
+	}
+
+	static vector<uint8_t> sample(Mix mix)
+	{
+		Request req(SOCKS6_REQUEST_CONNECT, Address("www.example.com"), 443);
+		fillRequestOptions(&req.options, mix);
+		return packToVector(req);
+	}
+
+	typedef S6M_Request CMessage;
+
+	static constexpr auto cParse     = S6M_Request_parse;
+	static constexpr auto cParseInto = S6M_Request_parseInto;
+	static constexpr auto cPack      = S6M_Request_pack;
+	static constexpr auto cFree      = S6M_Request_free;
+};
+
+template <>
+struct Traits<AuthenticationReply>
+{
+	static AuthenticationReply blank()
+	{
+		return AuthenticationReply(SOCKS6_AUTH_REPLY_SUCCESS);
+	}
+
+	static vector<uint8_t> sample(Mix mix)
+	{
+		AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+		fillAuthReplyOptions(&authReply.options, mix);
+		return packToVector(authReply);
+	}
+
+	typedef S6M_AuthReply CMessage;
+
+	static constexpr auto cParse     = S6M_AuthReply_parse;
+	static constexpr auto cParseInto = S6M_AuthReply_parseInto;
+	static constexpr auto cPack      = S6M_AuthReply_pack;
+	static constexpr auto cFree      = S6M_AuthReply_free;
+};
+
+/* operation replies carry no options */
+template <>
+struct Traits<OperationReply>
+{
+	static OperationReply blank()
+	{
+		return OperationReply(SOCKS6_OPERATION_REPLY_SUCCESS);
+	}
+
+	static vector<uint8_t> sample(Mix)
+	{
+		return packToVector(OperationReply(SOCKS6_OPERATION_REPLY_SUCCESS, Address(in_addr { htonl(0x0a000001) }), 443));
+	}
+
+	typedef S6M_OpReply CMessage;
+
+	static constexpr auto cParse     = S6M_OpReply_parse;
+	static constexpr auto cParseInto = S6M_OpReply_parseInto;
+	static constexpr auto cPack      = S6M_OpReply_pack;
+	static constexpr auto cFree      = S6M_OpReply_free;
+};
+
+/* no C bindings */
+template <>
+struct Traits<DatagramHeader>
+{
+	static DatagramHeader blank()
+	{
+		return DatagramHeader((uint64_t)0);
+	}
+
+	static vector<uint8_t> sample(Mix)
+	{
+		return packToVector(DatagramHeader(0x0123456789abcdef, Address(in_addr { htonl(0x0a000001) }), 53));
+	}
+};
+
+template <>
+struct Traits<UserPasswordRequest>
+{
+	static UserPasswordRequest blank()
+	{
+		return UserPasswordRequest({ "-", "-" });
+	}
+
+	static vector<uint8_t> sample(Mix)
+	{
+		return packToVector(UserPasswordRequest({ "user", "password" }));
+	}
+
+	typedef S6M_PasswdReq CMessage;
+
+	static constexpr auto cParse = S6M_PasswdReq_parse;
+	static constexpr auto cPack  = S6M_PasswdReq_pack;
+	static constexpr auto cFree  = S6M_PasswdReq_free;
+};
+
+template <>
+struct Traits<UserPasswordReply>
+{
+	static UserPasswordReply blank()
+	{
+		return UserPasswordReply(false);
+	}
+
+	static vector<uint8_t> sample(Mix)
+	{
+		return packToVector(UserPasswordReply(true));
+	}
+
+	typedef S6M_PasswdReply CMessage;
+
+	static constexpr auto cParse = S6M_PasswdReply_parse;
+	static constexpr auto cPack  = S6M_PasswdReply_pack;
+	static constexpr auto cFree  = S6M_PasswdReply_free;
+};
+
+template <typename MSG, Mix MIX>
+vector<uint8_t> *wire()
+{
+	static vector<uint8_t> buf = Traits<MSG>::sample(MIX);
+	return &buf;
+}
+
+template <typename MSG, Mix MIX>
+void parse(uint64_t iterations)
+{
+	vector<uint8_t> *buf = wire<MSG, MIX>();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(buf->data(), buf->size());
+		MSG msg = Traits<MSG>::blank();
+		if (MSG::parse(&bb, &msg) != PR_SUCCESS)
+			abort();
+		Bench::keep(msg);
+	}
+}
+
+template <typename MSG, Mix MIX>
+void pack(uint64_t iterations)
+{
+	vector<uint8_t> *buf = wire<MSG, MIX>();
+	ByteBuffer bb(buf->data(), buf->size());
+	MSG msg = Traits<MSG>::blank();
+	if (MSG::parse(&bb, &msg) != PR_SUCCESS)
+		abort();
+
+	vector<uint8_t> out(BUF_SIZE);
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		msg.pack(out.data(), out.size());
+		Bench::keep(out);
+	}
+}
+
+template <typename MSG, Mix MIX>
+void cParse(uint64_t iterations)
+{
+	vector<uint8_t> *buf = wire<MSG, MIX>();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		typename Traits<MSG>::CMessage *msg;
+		if (Traits<MSG>::cParse(buf->data(), buf->size(), &msg) < 0)
+			abort();
+		Traits<MSG>::cFree(msg);
+	}
+}
+
+template <typename MSG, Mix MIX>
+void cParseInto(uint64_t iterations)
+{
+	vector<uint8_t> *buf = wire<MSG, MIX>();
+	S6M_ParseStorage storage;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		typename Traits<MSG>::CMessage msg;
+		if (Traits<MSG>::cParseInto(buf->data(), buf->size(), &msg, &storage) < 0)
+			abort();
+		Bench::keep(msg);
+	}
+}
+
+template <typename MSG, Mix MIX>
+void cPack(uint64_t iterations)
+{
+	vector<uint8_t> *buf = wire<MSG, MIX>();
+	typename Traits<MSG>::CMessage *msg;
+	if (Traits<MSG>::cParse(buf->data(), buf->size(), &msg) < 0)
+		abort();
+
+	vector<uint8_t> out(BUF_SIZE);
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		if (Traits<MSG>::cPack(msg, out.data(), out.size()) < 0)
+			abort();
+		Bench::keep(out);
+	}
+
+	Traits<MSG>::cFree(msg);
+}
+
+}
+
+#define S6M_BENCH_CPP(MSG, MIX, SUFFIX) \
+	static Bench::Registration MSG##_parse##SUFFIX(#MSG, "Parse" #SUFFIX, parse<MSG, MIX>); \
+	static Bench::Registration MSG##_pack##SUFFIX (#MSG, "Pack"  #SUFFIX, pack<MSG, MIX>);
+
+#define S6M_BENCH_C(MSG, MIX, SUFFIX) \
+	static Bench::Registration MSG##_cParse##SUFFIX(#MSG, "CParse" #SUFFIX, cParse<MSG, MIX>); \
+	static Bench::Registration MSG##_cPack##SUFFIX (#MSG, "CPack"  #SUFFIX, cPack<MSG, MIX>);
+
+#define S6M_BENCH_C_INTO(MSG, MIX, SUFFIX) \
+	static Bench::Registration MSG##_cParseInto##SUFFIX(#MSG, "CParseInto" #SUFFIX, cParseInto<MSG, MIX>);
+
+#define S6M_BENCH_ALL(MSG, MIX, SUFFIX) \
+	S6M_BENCH_CPP(MSG, MIX, SUFFIX) \
+	S6M_BENCH_C(MSG, MIX, SUFFIX) \
+	S6M_BENCH_C_INTO(MSG, MIX, SUFFIX)
+
+S6M_BENCH_ALL(Request, NO_OPTIONS,          NoOptions)
+S6M_BENCH_ALL(Request, STACK,               Stack)
+S6M_BENCH_ALL(Request, SESSION_IDEMPOTENCE, SessionIdempotence)
+S6M_BENCH_ALL(Request, USER_PASSWORD,       UserPassword)
+S6M_BENCH_ALL(Request, FULL,                Full)
+
+S6M_BENCH_ALL(AuthenticationReply, NO_OPTIONS,          NoOptions)
+S6M_BENCH_ALL(AuthenticationReply, STACK,               Stack)
+S6M_BENCH_ALL(AuthenticationReply, SESSION_IDEMPOTENCE, SessionIdempotence)
+S6M_BENCH_ALL(AuthenticationReply, USER_PASSWORD,       UserPassword)
+S6M_BENCH_ALL(AuthenticationReply, FULL,                Full)
+
+S6M_BENCH_ALL(OperationReply, NO_OPTIONS, NoOptions)
+
+S6M_BENCH_CPP(DatagramHeader, NO_OPTIONS, )
+
+S6M_BENCH_CPP(UserPasswordRequest, NO_OPTIONS, )
+S6M_BENCH_C  (UserPasswordRequest, NO_OPTIONS, )
+
+S6M_BENCH_CPP(UserPasswordReply, NO_OPTIONS, )
+S6M_BENCH_C  (UserPasswordReply, NO_OPTIONS, )
@@ -0,0 +1,85 @@
+#include <string.h>
+#include <vector>
+#include "socks6msg.h"
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Authentication reply as a proxy builds it: session, idempotence window and stack options.
+ */
+
+namespace
+{
+
+const size_t BUF_SIZE = 1500;
+
+uint8_t sessionID[16] = { 0x5a };
+
+S6M_AuthReply *cAuthReply()
+{
+	static S6M_StackOption stackOpts[] = {
+		{ SOCKS6_STACK_LEG_CLIENT_PROXY, SOCKS6_STACK_LEVEL_IP,  SOCKS6_STACK_CODE_TOS, 0x10 },
+		{ SOCKS6_STACK_LEG_PROXY_REMOTE, SOCKS6_STACK_LEVEL_TCP, SOCKS6_STACK_CODE_TFO, 1 },
+	};
+	static S6M_AuthReply authReply = []() {
+		S6M_AuthReply authReply;
+		memset(&authReply, 0, sizeof(authReply));
+		authReply.code = SOCKS6_AUTH_REPLY_SUCCESS;
+		authReply.optionSet.stack.options = stackOpts;
+		authReply.optionSet.stack.count = sizeof(stackOpts) / sizeof(stackOpts[0]);
+		authReply.optionSet.session.id = sessionID;
+		authReply.optionSet.session.idLength = sizeof(sessionID);
+		authReply.optionSet.idempotence.windowBase = 1000;
+		authReply.optionSet.idempotence.windowSize = 100;
+		return authReply;
+	}();
+	return &authReply;
+}
+
+}
+
+S6M_BENCH(Pack, CPackedSizeThenPack)
+{
+	uint8_t buf[BUF_SIZE];
+	
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ssize_t size = S6M_AuthReply_packedSize(cAuthReply());
+		if (size > 0 && (size_t)size <= sizeof(buf))
+			S6M_AuthReply_pack(cAuthReply(), buf, sizeof(buf));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(Pack, CPackOrSize)
+{
+	uint8_t buf[BUF_SIZE];
+	
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		S6M_AuthReply_packOrSize(cAuthReply(), buf, sizeof(buf));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(Pack, AppendToVector)
+{
+	vector<uint8_t> out;
+	out.reserve(BUF_SIZE);
+	
+	AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+	authReply.options.stack.tos.set(SOCKS6_STACK_LEG_CLIENT_PROXY, 0x10);
+	authReply.options.stack.tfo.set(SOCKS6_STACK_LEG_PROXY_REMOTE, 1);
+	authReply.options.session.setID(SessionID(sizeof(sessionID), 0x5a));
+	authReply.options.idempotence.advertise({ 1000, 100 });
+	
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		out.clear();
+		authReply.pack(&out);
+		Bench::keep(out);
+	}
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "socks6msg.hh"
+#include "prepackedmessage.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Replies of a fixed shape: built and packed every time versus patched into a template and copied.
+ * Every template is first checked against pack() for a few values of its fields.
+ */
+
+namespace
+{
+
+const size_t BUF_SIZE = 1024;
+const size_t ID_SIZE = 16;
+
+SessionID sessionID(uint64_t i)
+{
+	SessionID id(ID_SIZE, 0);
+	memcpy(id.data(), &i, sizeof(i));
+	return id;
+}
+
+in_addr address(uint64_t i)
+{
+	return { htonl(0x0a000000 | (uint32_t)(i & 0xffffff)) };
+}
+
+/* success + new session ID + idempotence window */
+void fill(AuthenticationReply *authReply, uint64_t i)
+{
+	authReply->options.session.setID(sessionID(i));
+	authReply->options.idempotence.advertise({ (uint32_t)i, 100 });
+}
+
+OperationReply opReply(uint64_t i)
+{
+	return OperationReply(SOCKS6_OPERATION_REPLY_SUCCESS, Address(address(i)), (uint16_t)i);
+}
+
+/* tpl has been patched to match msg */
+template <typename MSG>
+void check(const PrepackedMessage &tpl, const MSG &msg)
+{
+	vector<uint8_t> expected(BUF_SIZE);
+	size_t expectedSize = msg.pack(expected.data(), expected.size());
+	
+	if (tpl.packedSize() != expectedSize || memcmp(tpl.getBytes(), expected.data(), expectedSize) != 0)
+		abort();
+}
+
+}
+
+S6M_BENCH(Prepacked, AuthReplyPack)
+{
+	vector<uint8_t> buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+		fill(&authReply, i);
+		Bench::keep(authReply.pack(buf.data(), buf.size()));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(Prepacked, AuthReplyTemplate)
+{
+	AuthenticationReply authReply(SOCKS6_AUTH_REPLY_SUCCESS);
+	fill(&authReply, 0);
+	PrepackedMessage tpl(authReply);
+	for (uint64_t i : { 0x0UL, 0x1UL, 0xdeadbeefUL, 0xffffffffUL })
+	{
+		PrepackedMessage patched(tpl);
+		patched.setSessionID(sessionID(i));
+		patched.setWindow({ (uint32_t)i, 100 });
+		AuthenticationReply expected(SOCKS6_AUTH_REPLY_SUCCESS);
+		fill(&expected, i);
+		check(patched, expected);
+	}
+	vector<uint8_t> buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		SessionID id = sessionID(i);
+		tpl.setSessionID(id);
+		tpl.setWindow({ (uint32_t)i, 100 });
+		Bench::keep(tpl.pack(buf.data(), buf.size()));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(Prepacked, OpReplyPack)
+{
+	vector<uint8_t> buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		Bench::keep(opReply(i).pack(buf.data(), buf.size()));
+		Bench::keep(buf);
+	}
+}
+
+S6M_BENCH(Prepacked, OpReplyTemplate)
+{
+	PrepackedMessage tpl(opReply(0));
+	for (uint64_t i : { 0x0UL, 0x1UL, 0xbeefUL, 0xffffffUL })
+	{
+		PrepackedMessage patched(tpl);
+		patched.setAddress(address(i));
+		patched.setPort((uint16_t)i);
+		check(patched, opReply(i));
+	}
+	vector<uint8_t> buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		tpl.setAddress(address(i));
+		tpl.setPort((uint16_t)i);
+		Bench::keep(tpl.pack(buf.data(), buf.size()));
+		Bench::keep(buf);
+	}
+}
+
+/* failures only vary in their code */
+S6M_BENCH(Prepacked, FailureTemplate)
+{
+	PrepackedMessage tpl { OperationReply(SOCKS6_OPERATION_REPLY_FAILURE) };
+	tpl.setCode(SOCKS6_OPERATION_REPLY_REFUSED);
+	check(tpl, OperationReply(SOCKS6_OPERATION_REPLY_REFUSED));
+	vector<uint8_t> buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		tpl.setCode(i & 1 ? SOCKS6_OPERATION_REPLY_FAILURE : SOCKS6_OPERATION_REPLY_REFUSED);
+		Bench::keep(tpl.pack(buf.data(), buf.size()));
+		Bench::keep(buf);
+	}
+}
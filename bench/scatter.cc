@@ -0,0 +1,83 @@
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Requests that straddle two ring segments: copied into one buffer and parsed, versus parsed across the segments.
+ * Splitting inside the session ID has the whole option copied either way; splitting inside the domain has only the domain copied.
+ */
+
+namespace
+{
+
+struct Segments
+{
+	vector<uint8_t> first;
+	vector<uint8_t> second;
+	iovec iovs[2];
+	size_t size;
+
+	Segments(size_t idSize, bool splitID)
+	{
+		Request req(SOCKS6_REQUEST_CONNECT, Address(string("example.com")), 443);
+		req.options.session.setID(SessionID(idSize, 0x5a));
+		req.options.userPassword.setCredentials(pair<string, string>("user", "password"));
+
+		vector<uint8_t> buf(SOCKS6_OPTIONS_LENGTH_MAX + 1024);
+		size = req.pack(buf.data(), buf.size());
+
+		/* the domain starts right after the fixed-size part */
+		size_t split = splitID ? size - idSize / 2 : sizeof(SOCKS6Request) + 4;
+		first.assign(buf.begin(), buf.begin() + split);
+		second.assign(buf.begin() + split, buf.begin() + size);
+		iovs[0] = { first.data(), first.size() };
+		iovs[1] = { second.data(), second.size() };
+	}
+};
+
+template <size_t ID_SIZE, bool SPLIT_ID>
+void linearize(uint64_t iterations)
+{
+	Segments segments(ID_SIZE, SPLIT_ID);
+	vector<uint8_t> linear(segments.size);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		memcpy(linear.data(), segments.first.data(), segments.first.size());
+		memcpy(linear.data() + segments.first.size(), segments.second.data(), segments.second.size());
+
+		ByteBuffer bb(linear.data(), linear.size());
+		RequestView req;
+		Bench::keep(RequestView::parse(&bb, &req));
+		Bench::keep(req);
+	}
+}
+
+template <size_t ID_SIZE, bool SPLIT_ID>
+void scatter(uint64_t iterations)
+{
+	Segments segments(ID_SIZE, SPLIT_ID);
+	vector<uint8_t> scratch(ScatterBuffer::SCRATCH_SIZE);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ScatterBuffer sb(segments.iovs, 2, scratch.data(), scratch.size());
+		RequestView req;
+		Bench::keep(RequestView::parse(&sb, &req));
+		Bench::keep(req);
+	}
+}
+
+}
+
+static Bench::Registration scatter_linearize16  ("Scatter", "Linearize16",    linearize<16, false>);
+static Bench::Registration scatter_scatter16    ("Scatter", "Scatter16",      scatter<16, false>);
+static Bench::Registration scatter_linearize1K  ("Scatter", "Linearize1K",    linearize<1024, false>);
+static Bench::Registration scatter_scatter1K    ("Scatter", "Scatter1K",      scatter<1024, false>);
+static Bench::Registration scatter_linearize16K ("Scatter", "Linearize16K",   linearize<SOCKS6_OPTIONS_LENGTH_MAX - 64, false>);
+static Bench::Registration scatter_scatter16K   ("Scatter", "Scatter16K",     scatter<SOCKS6_OPTIONS_LENGTH_MAX - 64, false>);
+static Bench::Registration scatter_linearizeID1K("Scatter", "LinearizeInID1K", linearize<1024, true>);
+static Bench::Registration scatter_scatterID1K  ("Scatter", "ScatterInID1K",  scatter<1024, true>);
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "socks6msg.hh"
+#include "sessiontable.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Session lookups by 16-byte session ID over 100K sessions, split across 1 to 8 threads:
+ * SessionTable, and a single std::unordered_map behind a mutex for reference.
+ * Thread start-up is part of each run, so use a long enough -t.
+ */
+
+namespace
+{
+
+const size_t SESSIONS = 100000;
+const size_t ID_SIZE  = 16;
+const size_t LOOKUPS  = 1 << 16;
+
+struct Session
+{
+	uint8_t id[ID_SIZE];
+};
+
+typedef SessionTable<Session> Table;
+
+Span<const uint8_t> idOf(const Session &session)
+{
+	return { session.id, ID_SIZE };
+}
+
+void check()
+{
+	Table table(std::chrono::seconds(60), 4);
+	Session a, b;
+	memset(a.id, 'a', ID_SIZE);
+	memset(b.id, 'b', ID_SIZE);
+	Table::Clock::time_point now = Table::Clock::now();
+
+	if (!table.insert(idOf(a), &a, now) || table.insert(idOf(a), &b, now) || !table.insert(idOf(b), &b, now))
+		abort();
+	if (table.find(idOf(a), now) != &a || table.find(idOf(b), now) != &b || table.find({ a.id, ID_SIZE - 1 }, now))
+		abort();
+
+	/* b is used, a is not: only a times out */
+	if (table.find(idOf(b), now + std::chrono::seconds(50)) != &b)
+		abort();
+	now += std::chrono::seconds(70);
+	if (table.find(idOf(a), now))
+		abort();
+	size_t expired = table.expire([&a](Session *session) {
+		if (session != &a)
+			abort();
+	}, now);
+	if (expired != 1 || table.size() != 1 || table.find(idOf(b), now) != &b)
+		abort();
+
+	/* teardown, through a request */
+	Request req(SOCKS6_REQUEST_NOOP);
+	SessionID id(b.id, b.id + ID_SIZE);
+	req.options.session.setID(id);
+	req.options.session.tearDown();
+	bool tornDown;
+	if (table.lookup(req.options.session, &tornDown, now) != &b || !tornDown || table.size() != 0)
+		abort();
+	if (table.lookup(req.options.session, &tornDown, now) || tornDown)
+		abort();
+}
+
+struct IDHash
+{
+	size_t operator ()(const string &id) const
+	{
+		return std::hash<string>()(id);
+	}
+};
+
+struct Fixture
+{
+	vector<Session> sessions;
+	Table table;
+	mutex mapLock;
+	unordered_map<string, Session *> map;
+	vector<uint32_t> lookups;
+
+	Fixture()
+		: sessions(SESSIONS), table(std::chrono::hours(1)), lookups(LOOKUPS)
+	{
+		check();
+
+		mt19937_64 random(1);
+		map.reserve(SESSIONS);
+		for (Session &session: sessions)
+		{
+			for (uint8_t &byte: session.id)
+				byte = random();
+			if (!table.insert(idOf(session), &session))
+				abort();
+			map[string((const char *)session.id, ID_SIZE)] = &session;
+		}
+		for (uint32_t &lookup: lookups)
+			lookup = random() % SESSIONS;
+	}
+};
+
+Fixture *fixture()
+{
+	static Fixture fixture;
+	return &fixture;
+}
+
+template <typename WORK>
+void spread(uint64_t iterations, int threadCount, WORK work)
+{
+	vector<thread> threads;
+	for (int t = 0; t < threadCount; t++)
+	{
+		uint64_t first = iterations * t / threadCount;
+		uint64_t last  = iterations * (t + 1) / threadCount;
+		threads.emplace_back([=]() {
+			work(first, last);
+		});
+	}
+	for (thread &th: threads)
+		th.join();
+}
+
+template <int THREADS>
+void find(uint64_t iterations)
+{
+	Fixture *f = fixture();
+	spread(iterations, THREADS, [f](uint64_t first, uint64_t last) {
+		for (uint64_t i = first; i < last; i++)
+		{
+			Session *session = f->table.find(idOf(f->sessions[f->lookups[i % LOOKUPS]]));
+			Bench::keep(session);
+		}
+	});
+}
+
+template <int THREADS>
+void lockedMap(uint64_t iterations)
+{
+	Fixture *f = fixture();
+	spread(iterations, THREADS, [f](uint64_t first, uint64_t last) {
+		for (uint64_t i = first; i < last; i++)
+		{
+			const Session &key = f->sessions[f->lookups[i % LOOKUPS]];
+			/* a std::string key has to be built for every lookup */
+			string id((const char *)key.id, ID_SIZE);
+			lock_guard<mutex> guard(f->mapLock);
+			auto it = f->map.find(id);
+			Session *session = it != f->map.end() ? it->second : nullptr;
+			Bench::keep(session);
+		}
+	});
+}
+
+}
+
+#define S6M_BENCH_SESSIONTABLE(N) \
+	static Bench::Registration sessionTable_find##N     ("SessionTable", "Find"      #N "T", find<N>); \
+	static Bench::Registration sessionTable_lockedMap##N("SessionTable", "LockedMap" #N "T", lockedMap<N>);
+
+S6M_BENCH_SESSIONTABLE(1)
+S6M_BENCH_SESSIONTABLE(2)
+S6M_BENCH_SESSIONTABLE(4)
+S6M_BENCH_SESSIONTABLE(8)
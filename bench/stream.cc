@@ -0,0 +1,67 @@
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * A request with a large options block arriving in small reads.
+ */
+
+namespace
+{
+
+const size_t CHUNK = 64;
+
+const vector<uint8_t> &message()
+{
+	static const vector<uint8_t> buf = []() {
+		Request req(SOCKS6_REQUEST_CONNECT, Address("example.com"), 443);
+		req.options.session.setID(SessionID(4000, 0x5a));
+
+		vector<uint8_t> buf(req.packedSize());
+		req.pack(buf.data(), buf.size());
+		return buf;
+	}();
+	return buf;
+}
+
+}
+
+S6M_BENCH(Stream, ReparseEachRead)
+{
+	const vector<uint8_t> &msg = message();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t received = CHUNK; ; received += CHUNK)
+		{
+			received = min(received, msg.size());
+
+			ByteBuffer bb(const_cast<uint8_t *>(msg.data()), received);
+			Request req(SOCKS6_REQUEST_NOOP);
+			if (Request::parse(&bb, &req) != PR_BUFFER)
+				break;
+		}
+	}
+}
+
+S6M_BENCH(Stream, StreamParser)
+{
+	const vector<uint8_t> &msg = message();
+	StreamParser<Request> parser;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t offset = 0; ; offset += CHUNK)
+		{
+			ByteBuffer bb(const_cast<uint8_t *>(msg.data()) + offset, min(CHUNK, msg.size() - offset));
+			parser.feed(&bb);
+
+			Request req(SOCKS6_REQUEST_NOOP);
+			if (parser.parse(&req) != PR_BUFFER)
+				break;
+		}
+	}
+}
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "socks6msg.hh"
+#include "tokenallocator.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Client-side token allocation out of an advertised window: the lock-free allocator,
+ * the same with setToken() on a fresh request, and a mutex-guarded counter for reference.
+ */
+
+namespace
+{
+
+const size_t BURST = 64;
+
+void advertise(AuthenticationReply *reply, uint32_t base, uint32_t size)
+{
+	reply->options.idempotence.advertise({ base, size });
+}
+
+void check()
+{
+	IdempotenceTokenAllocator unseeded;
+	if (unseeded.allocate())
+		abort();
+
+	AuthenticationReply reply(SOCKS6_AUTH_REPLY_SUCCESS);
+	advertise(&reply, UINT32_MAX - 1, 3);
+	IdempotenceTokenAllocator allocator(reply.options.idempotence);
+	if (allocator.allocate() != UINT32_MAX - 1 || allocator.allocate() != UINT32_MAX || allocator.allocate() != 0u)
+		abort();
+	if (allocator.allocate() || allocator.getRemaining() != 0)
+		abort();
+
+	AuthenticationReply verdict(SOCKS6_AUTH_REPLY_SUCCESS);
+	verdict.options.idempotence.setReply(false);
+	if (allocator.settle(verdict.options.idempotence) != false || allocator.getRejected() != 1 || allocator.allocate())
+		abort();
+
+	AuthenticationReply renewed(SOCKS6_AUTH_REPLY_SUCCESS);
+	renewed.options.idempotence.setReply(true);
+	advertise(&renewed, 1000, 1 << 16);
+	if (allocator.settle(renewed.options.idempotence) != true || allocator.getAccepted() != 1 || allocator.allocate() != 1000u)
+		abort();
+
+	/* racing allocations: every token of the window, each exactly once */
+	vector<vector<uint32_t>> tokens(4);
+	vector<thread> threads;
+	for (size_t t = 0; t < tokens.size(); t++)
+	{
+		threads.emplace_back([&allocator, &tokens, t]() {
+			while (optional<uint32_t> token = allocator.allocate())
+				tokens[t].push_back(*token);
+		});
+	}
+	for (thread &th: threads)
+		th.join();
+	vector<bool> seen(1 << 16);
+	seen[0] = true;
+	for (const vector<uint32_t> &list: tokens)
+	{
+		for (uint32_t token: list)
+		{
+			if (token < 1000 || token - 1000 >= seen.size() || seen[token - 1000])
+				abort();
+			seen[token - 1000] = true;
+		}
+	}
+	for (bool s: seen)
+	{
+		if (!s)
+			abort();
+	}
+
+	Request req(SOCKS6_REQUEST_NOOP);
+	if (allocator.assign(&req.options.idempotence))
+		abort();
+}
+
+/* big enough that the window never runs out over a run */
+IdempotenceTokenAllocator *allocator()
+{
+	static IdempotenceTokenAllocator *allocator = []() {
+		check();
+
+		AuthenticationReply reply(SOCKS6_AUTH_REPLY_SUCCESS);
+		advertise(&reply, 0, SOCKS6_TOKEN_WINDOW_MAX);
+		return new IdempotenceTokenAllocator(reply.options.idempotence);
+	}();
+	return allocator;
+}
+
+S6M_BENCH(TokenAllocator, Allocate)
+{
+	IdempotenceTokenAllocator *a = allocator();
+	optional<uint32_t> tokens[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+			tokens[j] = a->allocate();
+		Bench::keep(tokens);
+	}
+}
+
+S6M_BENCH(TokenAllocator, AssignToRequest)
+{
+	IdempotenceTokenAllocator *a = allocator();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		Request req(SOCKS6_REQUEST_CONNECT, Address(in_addr { 0x0100007f }), 80);
+		a->assign(&req.options.idempotence);
+		Bench::keep(req);
+	}
+}
+
+S6M_BENCH(TokenAllocator, MutexCounter)
+{
+	static mutex lock;
+	static uint32_t base = 0;
+	static uint32_t size = SOCKS6_TOKEN_WINDOW_MAX;
+	static uint64_t used = 0;
+	optional<uint32_t> tokens[BURST];
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		for (size_t j = 0; j < BURST; j++)
+		{
+			lock_guard<mutex> guard(lock);
+			tokens[j] = used < size ? optional<uint32_t>(base + used++) : nullopt;
+		}
+		Bench::keep(tokens);
+	}
+}
+
+}
@@ -0,0 +1,99 @@
+#include <vector>
+#include "socks6msg.h"
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Handshake request as a proxy sees it: domain, session ticket, methods and credentials.
+ */
+
+namespace
+{
+
+const vector<uint8_t> &message()
+{
+	static const vector<uint8_t> buf = []() {
+		Request req(SOCKS6_REQUEST_CONNECT, Address("www.example.com"), 443);
+		req.options.session.setID(SessionID(16, 0x5a));
+		req.options.authMethods.advertise({ SOCKS6_METHOD_USRPASSWD, SOCKS6_METHOD_GSSAPI }, 0);
+		req.options.userPassword.setCredentials({ "user", "password" });
+		req.options.idempotence.setToken(1234);
+
+		vector<uint8_t> buf(req.packedSize());
+		req.pack(buf.data(), buf.size());
+		return buf;
+	}();
+	return buf;
+}
+
+}
+
+S6M_BENCH(Views, Request)
+{
+	const vector<uint8_t> &msg = message();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		Request req(SOCKS6_REQUEST_NOOP);
+		Request::parse(&bb, &req);
+		Bench::keep(req);
+	}
+}
+
+S6M_BENCH(Views, RequestView)
+{
+	const vector<uint8_t> &msg = message();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		RequestView req;
+		RequestView::parse(&bb, &req);
+		Bench::keep(req);
+	}
+}
+
+/* same, with parse statistics on */
+S6M_BENCH(Views, RequestViewCounted)
+{
+	const vector<uint8_t> &msg = message();
+	ParseStats::enable(true);
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(const_cast<uint8_t *>(msg.data()), msg.size());
+		RequestView req;
+		RequestView::parse(&bb, &req);
+		Bench::keep(req);
+	}
+	ParseStats::enable(false);
+}
+
+S6M_BENCH(Views, CParse)
+{
+	vector<uint8_t> msg = message();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		S6M_Request *req;
+		if (S6M_Request_parse(msg.data(), msg.size(), &req) > 0)
+			S6M_Request_free(req);
+	}
+}
+
+S6M_BENCH(Views, CParseInto)
+{
+	vector<uint8_t> msg = message();
+	S6M_ParseStorage storage;
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		S6M_Request req;
+		S6M_Request_parseInto(msg.data(), msg.size(), &req, &storage);
+		Bench::keep(req);
+	}
+}
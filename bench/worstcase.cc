@@ -0,0 +1,131 @@
+#include <arpa/inet.h>
+#include <string.h>
+#include <vector>
+#include "socks6msg.hh"
+#include "bench.hh"
+
+using namespace std;
+using namespace S6M;
+
+/*
+ * Requests with full options blocks built to be as slow to parse as possible, next to an ordinary handshake request.
+ */
+
+namespace
+{
+
+vector<uint8_t> packRequest(const Request &req)
+{
+	vector<uint8_t> buf(req.packedSize());
+	req.pack(buf.data(), buf.size());
+	return buf;
+}
+
+/* IPv4 request, then options of the given kind and length up to a full options block */
+vector<uint8_t> fullRequest(uint16_t kind, uint16_t len)
+{
+	Request req(SOCKS6_REQUEST_CONNECT, Address(in_addr { htonl(0x7f000001) }), 80);
+	vector<uint8_t> buf = packRequest(req);
+	size_t optsOffset = buf.size();
+
+	while (buf.size() - optsOffset + len <= SOCKS6_OPTIONS_LENGTH_MAX)
+	{
+		size_t offset = buf.size();
+		buf.resize(offset + len);
+
+		SOCKS6Option *opt = reinterpret_cast<SOCKS6Option *>(&buf[offset]);
+		opt->kind = htons(kind);
+		opt->len  = htons(len);
+	}
+
+	SOCKS6Request *rawRequest = reinterpret_cast<SOCKS6Request *>(buf.data());
+	rawRequest->optionsLength = htons(buf.size() - optsOffset);
+	return buf;
+}
+
+vector<uint8_t> normal()
+{
+	Request req(SOCKS6_REQUEST_CONNECT, Address("www.example.com"), 443);
+	req.options.session.setID(SessionID(16, 0x5a));
+	req.options.authMethods.advertise({ SOCKS6_METHOD_USRPASSWD, SOCKS6_METHOD_GSSAPI }, 0);
+	req.options.userPassword.setCredentials({ "user", "password" });
+	req.options.idempotence.setToken(1234);
+	return packRequest(req);
+}
+
+/* the same session request, over and over */
+vector<uint8_t> duplicates()
+{
+	return fullRequest(SOCKS6_OPTION_SESSION_REQUEST, sizeof(SOCKS6Option));
+}
+
+vector<uint8_t> unknown()
+{
+	return fullRequest(SOCKS6_OPTION_IDEMPOTENCE_REJECT + 1, sizeof(SOCKS6Option));
+}
+
+/* unknown options up to the very last one, which has a bad length */
+vector<uint8_t> misaligned()
+{
+	vector<uint8_t> buf = unknown();
+	SOCKS6Option *last = reinterpret_cast<SOCKS6Option *>(&buf[buf.size() - sizeof(SOCKS6Option)]);
+	last->len = htons(sizeof(SOCKS6Option) + 2);
+	return buf;
+}
+
+/* one session ID that takes up the whole options block */
+vector<uint8_t> maxSessionID()
+{
+	return fullRequest(SOCKS6_OPTION_SESSION_ID, SOCKS6_OPTIONS_LENGTH_MAX);
+}
+
+/* session IDs as large as they come in pairs: the second is a duplicate */
+vector<uint8_t> duplicateSessionIDs()
+{
+	return fullRequest(SOCKS6_OPTION_SESSION_ID, SOCKS6_OPTIONS_LENGTH_MAX / 2);
+}
+
+template <vector<uint8_t> (*MAKE)()>
+void parse(uint64_t iterations)
+{
+	vector<uint8_t> msg = MAKE();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(msg.data(), msg.size());
+		Request req(SOCKS6_REQUEST_NOOP);
+		if (Request::parse(&bb, &req) != PR_SUCCESS)
+			abort();
+		Bench::keep(req);
+	}
+}
+
+template <vector<uint8_t> (*MAKE)()>
+void parseView(uint64_t iterations)
+{
+	vector<uint8_t> msg = MAKE();
+
+	for (uint64_t i = 0; i < iterations; i++)
+	{
+		ByteBuffer bb(msg.data(), msg.size());
+		RequestView req;
+		if (RequestView::parse(&bb, &req) != PR_SUCCESS)
+			abort();
+		Bench::keep(req);
+	}
+}
+
+}
+
+static Bench::Registration worstcase_normal             ("WorstCase", "Normal",                 parse<normal>);
+static Bench::Registration worstcase_duplicates         ("WorstCase", "Duplicates",             parse<duplicates>);
+static Bench::Registration worstcase_unknown            ("WorstCase", "Unknown",                parse<unknown>);
+static Bench::Registration worstcase_misaligned         ("WorstCase", "Misaligned",             parse<misaligned>);
+static Bench::Registration worstcase_maxSessionID       ("WorstCase", "MaxSessionID",           parse<maxSessionID>);
+static Bench::Registration worstcase_duplicateIDs       ("WorstCase", "DuplicateSessionIDs",    parse<duplicateSessionIDs>);
+static Bench::Registration worstcase_normalView         ("WorstCase", "NormalView",             parseView<normal>);
+static Bench::Registration worstcase_duplicatesView     ("WorstCase", "DuplicatesView",         parseView<duplicates>);
+static Bench::Registration worstcase_unknownView        ("WorstCase", "UnknownView",            parseView<unknown>);
+static Bench::Registration worstcase_misalignedView     ("WorstCase", "MisalignedView",         parseView<misaligned>);
+static Bench::Registration worstcase_maxSessionIDView   ("WorstCase", "MaxSessionIDView",       parseView<maxSessionID>);
+static Bench::Registration worstcase_duplicateIDsView   ("WorstCase", "DuplicateSessionIDsView", parseView<duplicateSessionIDs>);
@@ -1,12 +1,11 @@
 #include <stdlib.h>
 #include <string.h>
-#include <list>
-#include <set>
 #include <memory>
 #include <stdexcept>
 #include "socks6msg.h"
 #include "socks6msg.hh"
 #include "sanity.hh"
+#include "tracepoints.hh"
 
 using namespace std;
 using namespace S6M;
@@ -41,6 +40,53 @@ using namespace S6M;
 		(err) = S6M_ERR_UNSPEC; \
 	}
 
+static S6M_Error S6M_Error_FromParseResult(ParseResult result)
+{
+	switch (result)
+	{
+	case PR_SUCCESS:
+		return S6M_ERR_SUCCESS;
+	case PR_INVALID:
+		return S6M_ERR_INVALID;
+	case PR_ALLOC:
+		return S6M_ERR_ALLOC;
+	case PR_BUFFER:
+		return S6M_ERR_BUFFER;
+	case PR_OTHERVER:
+		return S6M_ERR_OTHERVER;
+	case PR_ADDRTYPE:
+		return S6M_ERR_ADDRTYPE;
+	}
+	
+	return S6M_ERR_UNSPEC;
+}
+
+/* capi_entry on the way in; capi_return on the way out, with what went through exit() */
+class CallTrace
+{
+	TraceCall call;
+	size_t    size;
+	ssize_t   result = 0;
+	
+public:
+	CallTrace(TraceCall call, size_t size = 0)
+		: call(call), size(size)
+	{
+		S6M_PROBE(capi_entry, call, size, 0);
+	}
+	
+	~CallTrace()
+	{
+		S6M_PROBE(capi_return, call, size, result);
+	}
+	
+	ssize_t exit(ssize_t result)
+	{
+		this->result = result;
+		return result;
+	}
+};
+
 struct S6M_PrivateClutter
 {
 	string domain;
@@ -93,56 +139,46 @@ static Address S6M_Addr_Flush(const S6M_Address *cAddr)
 	throw invalid_argument("Bad address type");
 }
 
-template <typename SET>
-static void fillStackOptions(const SET *set, list<S6M_StackOption> *stackOpts)
+/* 4 options, 2 legs each */
+static const int STACK_OPTIONS_MAX = 8;
+
+template <typename PAIR>
+static void fillStackOptions(const PAIR *pair, S6M_StackOption *stackOpts, int *count)
 {
-	static const vector<SOCKS6StackLeg> LEGS = { SOCKS6_STACK_LEG_CLIENT_PROXY, SOCKS6_STACK_LEG_PROXY_REMOTE };
-	
-	for (SOCKS6StackLeg leg: LEGS)
+	for (SOCKS6StackLeg leg: { SOCKS6_STACK_LEG_CLIENT_PROXY, SOCKS6_STACK_LEG_PROXY_REMOTE })
 	{
-		auto value = set->get(leg);
+		auto value = pair->get(leg);
 		if (!value)
 			continue;
 		
-		S6M_StackOption opt { leg, SET::Option::LEVEL, SET::Option::CODE, value.value() };
-		stackOpts->push_back(opt);
+		stackOpts[(*count)++] = { leg, PAIR::Option::LEVEL, PAIR::Option::CODE, value.value() };
 	}
 }
 
+/* returns the number of options */
+template <typename STACK>
+static int fillStackOptions(const STACK *stack, S6M_StackOption *stackOpts)
+{
+	int count = 0;
+	fillStackOptions(&stack->tos,     stackOpts, &count);
+	fillStackOptions(&stack->tfo,     stackOpts, &count);
+	fillStackOptions(&stack->mp,      stackOpts, &count);
+	fillStackOptions(&stack->backlog, stackOpts, &count);
+	return count;
+}
+
 /*
  * S6m_OptionSet
  */
 
-static void S6M_OptionSet_Fill(S6M_OptionSet *cSet, const OptionSet *cppSet, S6M_PrivateClutter *clutter)
+/* everything but the stack options, session ID, advertised methods and credentials */
+template <typename SET>
+static void S6M_OptionSet_FillScalars(S6M_OptionSet *cSet, const SET *cppSet)
 {
-	list<S6M_StackOption> stackOpts;
-	fillStackOptions(&cppSet->stack.tos,     &stackOpts);
-	fillStackOptions(&cppSet->stack.tfo,     &stackOpts);
-	fillStackOptions(&cppSet->stack.mp,      &stackOpts);
-	fillStackOptions(&cppSet->stack.backlog, &stackOpts);
-	if (!stackOpts.empty())
-	{
-		clutter->stackOpts.reserve(stackOpts.size());
-		int i = 0;
-		for (const S6M_StackOption &opt: stackOpts)
-			clutter->stackOpts[i++] = opt;
-		cSet->stack.options = clutter->stackOpts.data();
-	}
-	else
-	{
-		cSet = nullptr;
-	}
-	
 	if (cppSet->session.requested())
 		cSet->session.request = 1;
 	if (cppSet->session.tornDown())
 		cSet->session.tearDown = 1;
-	if (cppSet->session.getID())
-	{
-		clutter->sessionID = *(cppSet->session.getID());
-		cSet->session.id = clutter->sessionID.data();
-		cSet->session.idLength = clutter->sessionID.size();
-	}
 	if (cppSet->session.isOK())
 		cSet->session.ok = 1;
 	if (cppSet->session.rejected())
@@ -158,15 +194,40 @@ static void S6M_OptionSet_Fill(S6M_OptionSet *cSet, const OptionSet *cppSet, S6M
 	cSet->idempotence.reply = cppSet->idempotence.getReply().has_value();
 	cSet->idempotence.accepted = cppSet->idempotence.getReply().value_or(false);
 	
+	cSet->authMethods.initialDataLen = cppSet->authMethods.getInitialDataLen();
+	cSet->authMethods.selected = cppSet->authMethods.getSelected();
+	
+	if (cppSet->userPassword.getReply().has_value())
+	{
+		cSet->userPassword.replied = 1;
+		cSet->userPassword.success = cppSet->userPassword.getReply().value();
+	}
+}
+
+static void S6M_OptionSet_Fill(S6M_OptionSet *cSet, const OptionSet *cppSet, S6M_PrivateClutter *clutter)
+{
+	S6M_StackOption stackOpts[STACK_OPTIONS_MAX];
+	int stackCount = fillStackOptions(&cppSet->stack, stackOpts);
+	if (stackCount > 0)
+	{
+		clutter->stackOpts.assign(stackOpts, stackOpts + stackCount);
+		cSet->stack.options = clutter->stackOpts.data();
+		cSet->stack.count = stackCount;
+	}
+	
+	if (cppSet->session.getID())
+	{
+		clutter->sessionID = *(cppSet->session.getID());
+		cSet->session.id = clutter->sessionID.data();
+		cSet->session.idLength = clutter->sessionID.size();
+	}
+	
 	if (!cppSet->authMethods.getAdvertised()->empty())
 	{
-		clutter->knownMethods.reserve(cppSet->authMethods.getAdvertised()->size());
-		for (SOCKS6Method method: *(cppSet->authMethods.getAdvertised()))
-			clutter->knownMethods.push_back(method);
+		clutter->knownMethods.assign(cppSet->authMethods.getAdvertised()->begin(), cppSet->authMethods.getAdvertised()->end());
 		cSet->authMethods.known.methods = clutter->knownMethods.data();
+		cSet->authMethods.known.count = clutter->knownMethods.size();
 	}
-	cSet->authMethods.initialDataLen = cppSet->authMethods.getInitialDataLen();
-	cSet->authMethods.selected = cppSet->authMethods.getSelected();
 	
 	auto [user, passwd] = cppSet->userPassword.getCredentials();
 	if (user.length() > 0)
@@ -176,11 +237,93 @@ static void S6M_OptionSet_Fill(S6M_OptionSet *cSet, const OptionSet *cppSet, S6M
 		cSet->userPassword.username = clutter->username.c_str();
 		cSet->userPassword.passwd = clutter->password.c_str();
 	}
-	if (cppSet->userPassword.getReply().has_value())
+	
+	S6M_OptionSet_FillScalars(cSet, cppSet);
+}
+
+/* everything a message parsed by *_parseInto() points to, bar the session ID */
+struct S6M_PrivateStorage
+{
+	char            domain[UINT8_MAX + 1];
+	S6M_StackOption stackOpts[STACK_OPTIONS_MAX];
+	SOCKS6Method    knownMethods[UINT8_MAX + 1];
+	char            username[UINT8_MAX + 1];
+	char            password[UINT8_MAX + 1];
+};
+
+static_assert(sizeof(S6M_PrivateStorage) <= sizeof(S6M_ParseStorage), "S6M_PARSE_STORAGE_SIZE is too small");
+static_assert(alignof(S6M_PrivateStorage) <= alignof(S6M_ParseStorage), "S6M_ParseStorage is underaligned");
+
+static S6M_PrivateStorage *S6M_ParseStorage_Get(S6M_ParseStorage *storage)
+{
+	return reinterpret_cast<S6M_PrivateStorage *>(storage->priv.bytes);
+}
+
+/* str comes from a one-byte length field, so it always fits */
+static const char *S6M_String_Fill(char *dst, string_view str)
+{
+	memcpy(dst, str.data(), str.length());
+	dst[str.length()] = '\0';
+	return dst;
+}
+
+static void S6M_Addr_Fill(S6M_Address *cAddr, const AddressView &addr, S6M_PrivateStorage *storage)
+{
+	cAddr->type = addr.getType();
+	
+	switch (addr.getType())
 	{
-		cSet->userPassword.replied = 1;
-		cSet->userPassword.success = cppSet->userPassword.getReply().value();
+	case SOCKS6_ADDR_IPV4:
+		cAddr->ipv4 = addr.getIPv4();
+		break;
+		
+	case SOCKS6_ADDR_IPV6:
+		cAddr->ipv6 = addr.getIPv6();
+		break;
+		
+	case SOCKS6_ADDR_DOMAIN:
+		cAddr->domain = S6M_String_Fill(storage->domain, addr.getDomain());
+		break;
+	}
+}
+
+static void S6M_OptionSet_Fill(S6M_OptionSet *cSet, const OptionSetView *view, S6M_PrivateStorage *storage)
+{
+	int stackCount = fillStackOptions(&view->stack, storage->stackOpts);
+	if (stackCount > 0)
+	{
+		cSet->stack.options = storage->stackOpts;
+		cSet->stack.count = stackCount;
+	}
+	
+	Span<const uint8_t> id = view->session.getID();
+	if (!id.empty())
+	{
+		cSet->session.id = const_cast<uint8_t *>(id.data());
+		cSet->session.idLength = id.size();
+	}
+	
+	if (!view->authMethods.getAdvertised().empty())
+	{
+		/* same as OptionSet: sorted, no duplicates, NOAUTH implied */
+		AuthMethodMask methods(view->authMethods.getAdvertised());
+		methods.erase(SOCKS6_METHOD_NOAUTH);
+		
+		int count = 0;
+		for (SOCKS6Method method: methods)
+			storage->knownMethods[count++] = method;
+		cSet->authMethods.known.methods = storage->knownMethods;
+		cSet->authMethods.known.count = count;
 	}
+	
+	auto [user, passwd] = view->userPassword.getCredentials();
+	if (user.length() > 0)
+	{
+		cSet->userPassword.username = S6M_String_Fill(storage->username, user);
+		cSet->userPassword.passwd = S6M_String_Fill(storage->password, passwd);
+	}
+	
+	S6M_OptionSet_FillScalars(cSet, view);
 }
 
 static void S6M_OptionSet_Flush(OptionSet *cppSet, const S6M_OptionSet *cSet)
@@ -236,7 +379,7 @@ static void S6M_OptionSet_Flush(OptionSet *cppSet, const S6M_OptionSet *cSet)
 	
 	if (cSet->authMethods.known.methods)
 	{
-		set<SOCKS6Method> methods;
+		AuthMethodMask methods;
 		
 		for (int i = 0; i < cSet->authMethods.known.count; i++)
 			methods.insert((SOCKS6Method)cSet->authMethods.known.methods[i]);
@@ -262,6 +405,8 @@ struct S6M_RequestExtended: public S6M_Request
 
 ssize_t S6M_Request_packedSize(const S6M_Request *req)
 {
+	CallTrace trace(TC_REQUEST_PACKED_SIZE);
+	
 	S6M_Error err;
 	
 	try
@@ -270,15 +415,17 @@ ssize_t S6M_Request_packedSize(const S6M_Request *req)
 		Request cppReq(req->code, addr, req->port);
 		S6M_OptionSet_Flush(&cppReq.options, &req->optionSet);
 		
-		return cppReq.packedSize();
+		return trace.exit(cppReq.packedSize());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_Request_pack(const S6M_Request *req, uint8_t *buf, size_t size)
 {
+	CallTrace trace(TC_REQUEST_PACK, size);
+	
 	S6M_Error err;
 	
 	try
@@ -290,23 +437,50 @@ ssize_t S6M_Request_pack(const S6M_Request *req, uint8_t *buf, size_t size)
 		S6M_OptionSet_Flush(&cppReq.options, &req->optionSet);
 		cppReq.pack(&bb);
 		
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 		
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
+}
+
+ssize_t S6M_Request_packOrSize(const S6M_Request *req, uint8_t *buf, size_t size)
+{
+	CallTrace trace(TC_REQUEST_PACK_OR_SIZE, size);
+	
+	S6M_Error err;
+	
+	try
+	{
+		Address addr = S6M_Addr_Flush(&req->addr);
+		Request cppReq(req->code, addr, req->port);
+		S6M_OptionSet_Flush(&cppReq.options, &req->optionSet);
+		
+		size_t packedSize = cppReq.packedSize();
+		if (packedSize <= size)
+			cppReq.pack(buf, size);
+		return trace.exit(packedSize);
+	}
+	S6M_CATCH(err);
+	
+	return trace.exit(err);
 }
 
 ssize_t S6M_Request_parse(uint8_t *buf, size_t size, S6M_Request **preq)
 {
+	CallTrace trace(TC_REQUEST_PARSE, size);
+	
 	S6M_Error err;
 	S6M_RequestExtended *req = nullptr;
 	
 	try
 	{
 		ByteBuffer bb(buf, size);
-		Request cppReq(&bb);
+		Request cppReq(SOCKS6_REQUEST_NOOP);
+		ParseResult result = Request::parse(&bb, &cppReq);
+		if (result != PR_SUCCESS)
+			return trace.exit(S6M_Error_FromParseResult(result));
 		
 		req = new S6M_RequestExtended();
 		memset((S6M_Request *)req, 0, sizeof(S6M_Request));
@@ -317,17 +491,53 @@ ssize_t S6M_Request_parse(uint8_t *buf, size_t size, S6M_Request **preq)
 		S6M_OptionSet_Fill(&req->optionSet, &cppReq.options, &req->clutter);
 		
 		*preq = req;
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
 	if (req)
 		S6M_Request_free(req);
-	return err;
+	return trace.exit(err);
+}
+
+ssize_t S6M_Request_parseInto(uint8_t *buf, size_t size, S6M_Request *req, S6M_ParseStorage *storage)
+{
+	CallTrace trace(TC_REQUEST_PARSE_INTO, size);
+	
+	ByteBuffer bb(buf, size);
+	RequestView view;
+	ParseResult result = RequestView::parse(&bb, &view);
+	if (result != PR_SUCCESS)
+		return trace.exit(S6M_Error_FromParseResult(result));
+	
+	S6M_PrivateStorage *priv = S6M_ParseStorage_Get(storage);
+	memset(req, 0, sizeof(S6M_Request));
+	
+	req->code = view.code;
+	S6M_Addr_Fill(&req->addr, view.address, priv);
+	req->port = view.port;
+	S6M_OptionSet_Fill(&req->optionSet, &view.options, priv);
+	
+	return trace.exit(bb.getUsed());
+}
+
+ssize_t S6M_Request_peekSize(uint8_t *buf, size_t size)
+{
+	CallTrace trace(TC_REQUEST_PEEK_SIZE, size);
+	
+	ByteBuffer bb(buf, size);
+	size_t needed;
+	
+	ParseResult result = Request::peekSize(&bb, &needed);
+	if (result != PR_SUCCESS && result != PR_BUFFER)
+		return trace.exit(S6M_Error_FromParseResult(result));
+	return trace.exit(needed);
 }
 
 void S6M_Request_free(S6M_Request *req)
 {
+	CallTrace trace(TC_REQUEST_FREE);
+	
 	delete (S6M_RequestExtended * )req;
 }
 
@@ -342,6 +552,8 @@ struct S6M_AuthReplyExtended: public S6M_AuthReply
 
 ssize_t S6M_AuthReply_packedSize(const S6M_AuthReply *authReply)
 {
+	CallTrace trace(TC_AUTH_REPLY_PACKED_SIZE);
+	
 	S6M_Error err;
 	
 	try
@@ -349,16 +561,18 @@ ssize_t S6M_AuthReply_packedSize(const S6M_AuthReply *authReply)
 		AuthenticationReply cppAuthReply(authReply->code);
 		S6M_OptionSet_Flush(&cppAuthReply.options, &authReply->optionSet);
 		
-		return cppAuthReply.packedSize();
+		return trace.exit(cppAuthReply.packedSize());
 		
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_AuthReply_pack(const S6M_AuthReply *authReply, uint8_t *buf, size_t size)
 {
+	CallTrace trace(TC_AUTH_REPLY_PACK, size);
+	
 	S6M_Error err;
 	
 	try
@@ -369,23 +583,49 @@ ssize_t S6M_AuthReply_pack(const S6M_AuthReply *authReply, uint8_t *buf, size_t
 		S6M_OptionSet_Flush(&cppAuthReply.options, &authReply->optionSet);
 		cppAuthReply.pack(&bb);
 		
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
+		
+	}
+	S6M_CATCH(err);
+	
+	return trace.exit(err);
+}
+
+ssize_t S6M_AuthReply_packOrSize(const S6M_AuthReply *authReply, uint8_t *buf, size_t size)
+{
+	CallTrace trace(TC_AUTH_REPLY_PACK_OR_SIZE, size);
+	
+	S6M_Error err;
+	
+	try
+	{
+		AuthenticationReply cppAuthReply(authReply->code);
+		S6M_OptionSet_Flush(&cppAuthReply.options, &authReply->optionSet);
 		
+		size_t packedSize = cppAuthReply.packedSize();
+		if (packedSize <= size)
+			cppAuthReply.pack(buf, size);
+		return trace.exit(packedSize);
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_AuthReply_parse(uint8_t *buf, size_t size, S6M_AuthReply **pauthReply)
 {
+	CallTrace trace(TC_AUTH_REPLY_PARSE, size);
+	
 	S6M_Error err;
 	S6M_AuthReplyExtended *authReply = nullptr;
 	
 	try
 	{
 		ByteBuffer bb(buf, size);
-		AuthenticationReply cppAuthReply(&bb);
+		AuthenticationReply cppAuthReply(SOCKS6_AUTH_REPLY_SUCCESS);
+		ParseResult result = AuthenticationReply::parse(&bb, &cppAuthReply);
+		if (result != PR_SUCCESS)
+			return trace.exit(S6M_Error_FromParseResult(result));
 		
 		authReply = new S6M_AuthReplyExtended();
 		memset((S6M_AuthReply *)authReply, 0, sizeof(S6M_AuthReply));
@@ -394,17 +634,50 @@ ssize_t S6M_AuthReply_parse(uint8_t *buf, size_t size, S6M_AuthReply **pauthRepl
 		S6M_OptionSet_Fill(&authReply->optionSet, &cppAuthReply.options, &authReply->clutter);
 		
 		*pauthReply = authReply;
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
 	if (authReply)
 		S6M_AuthReply_free(authReply);
-	return err;
+	return trace.exit(err);
+}
+
+ssize_t S6M_AuthReply_parseInto(uint8_t *buf, size_t size, S6M_AuthReply *authReply, S6M_ParseStorage *storage)
+{
+	CallTrace trace(TC_AUTH_REPLY_PARSE_INTO, size);
+	
+	ByteBuffer bb(buf, size);
+	AuthenticationReplyView view;
+	ParseResult result = AuthenticationReplyView::parse(&bb, &view);
+	if (result != PR_SUCCESS)
+		return trace.exit(S6M_Error_FromParseResult(result));
+	
+	memset(authReply, 0, sizeof(S6M_AuthReply));
+	
+	authReply->code = view.code;
+	S6M_OptionSet_Fill(&authReply->optionSet, &view.options, S6M_ParseStorage_Get(storage));
+	
+	return trace.exit(bb.getUsed());
+}
+
+ssize_t S6M_AuthReply_peekSize(uint8_t *buf, size_t size)
+{
+	CallTrace trace(TC_AUTH_REPLY_PEEK_SIZE, size);
+	
+	ByteBuffer bb(buf, size);
+	size_t needed;
+	
+	ParseResult result = AuthenticationReply::peekSize(&bb, &needed);
+	if (result != PR_SUCCESS && result != PR_BUFFER)
+		return trace.exit(S6M_Error_FromParseResult(result));
+	return trace.exit(needed);
 }
 
 void S6M_AuthReply_free(S6M_AuthReply *authReply)
 {
+	CallTrace trace(TC_AUTH_REPLY_FREE);
+	
 	delete (S6M_AuthReplyExtended *)authReply;
 }
 
@@ -420,6 +693,8 @@ struct S6M_OpReplyExtended: public S6M_OpReply
 
 ssize_t S6M_OpReply_packedSize(const S6M_OpReply *opReply)
 {
+	CallTrace trace(TC_OP_REPLY_PACKED_SIZE);
+	
 	S6M_Error err;
 	
 	try
@@ -428,16 +703,18 @@ ssize_t S6M_OpReply_packedSize(const S6M_OpReply *opReply)
 		OperationReply cppOpReply(opReply->code, addr, opReply->port);
 		S6M_OptionSet_Flush(&cppOpReply.options, &opReply->optionSet);
 		
-		return cppOpReply.packedSize();
+		return trace.exit(cppOpReply.packedSize());
 		
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_OpReply_pack(const S6M_OpReply *opReply, uint8_t *buf, size_t size)
 {
+	CallTrace trace(TC_OP_REPLY_PACK, size);
+	
 	S6M_Error err;
 	
 	try
@@ -449,23 +726,50 @@ ssize_t S6M_OpReply_pack(const S6M_OpReply *opReply, uint8_t *buf, size_t size)
 		S6M_OptionSet_Flush(&cppOpReply.options, &opReply->optionSet);
 		cppOpReply.pack(&bb);
 		
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
+}
+
+ssize_t S6M_OpReply_packOrSize(const S6M_OpReply *opReply, uint8_t *buf, size_t size)
+{
+	CallTrace trace(TC_OP_REPLY_PACK_OR_SIZE, size);
+	
+	S6M_Error err;
+	
+	try
+	{
+		Address addr = S6M_Addr_Flush(&opReply->addr);
+		OperationReply cppOpReply(opReply->code, addr, opReply->port);
+		S6M_OptionSet_Flush(&cppOpReply.options, &opReply->optionSet);
+		
+		size_t packedSize = cppOpReply.packedSize();
+		if (packedSize <= size)
+			cppOpReply.pack(buf, size);
+		return trace.exit(packedSize);
+	}
+	S6M_CATCH(err);
+	
+	return trace.exit(err);
 }
 
 
 ssize_t S6M_OpReply_parse(uint8_t *buf, size_t size, S6M_OpReply **popReply)
 {
+	CallTrace trace(TC_OP_REPLY_PARSE, size);
+	
 	S6M_Error err;
 	S6M_OpReplyExtended *opReply = nullptr;
 	
 	try
 	{
 		ByteBuffer bb(buf, size);
-		OperationReply cppOpReply(&bb);
+		OperationReply cppOpReply(SOCKS6_OPERATION_REPLY_SUCCESS);
+		ParseResult result = OperationReply::parse(&bb, &cppOpReply);
+		if (result != PR_SUCCESS)
+			return trace.exit(S6M_Error_FromParseResult(result));
 		
 		opReply = new S6M_OpReplyExtended();
 		memset((S6M_OpReply *)opReply, 0, sizeof(S6M_OpReply));
@@ -476,18 +780,54 @@ ssize_t S6M_OpReply_parse(uint8_t *buf, size_t size, S6M_OpReply **popReply)
 		S6M_OptionSet_Fill(&opReply->optionSet, &cppOpReply.options, &opReply->clutter);
 		
 		*popReply = opReply;
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
 	if (opReply)
 		S6M_OpReply_free(opReply);
-	return err;
+	return trace.exit(err);
+}
+
+ssize_t S6M_OpReply_parseInto(uint8_t *buf, size_t size, S6M_OpReply *opReply, S6M_ParseStorage *storage)
+{
+	CallTrace trace(TC_OP_REPLY_PARSE_INTO, size);
+	
+	ByteBuffer bb(buf, size);
+	OperationReplyView view;
+	ParseResult result = OperationReplyView::parse(&bb, &view);
+	if (result != PR_SUCCESS)
+		return trace.exit(S6M_Error_FromParseResult(result));
+	
+	S6M_PrivateStorage *priv = S6M_ParseStorage_Get(storage);
+	memset(opReply, 0, sizeof(S6M_OpReply));
+	
+	opReply->code = view.code;
+	S6M_Addr_Fill(&opReply->addr, view.address, priv);
+	opReply->port = view.port;
+	S6M_OptionSet_Fill(&opReply->optionSet, &view.options, priv);
+	
+	return trace.exit(bb.getUsed());
 }
 
 
+ssize_t S6M_OpReply_peekSize(uint8_t *buf, size_t size)
+{
+	CallTrace trace(TC_OP_REPLY_PEEK_SIZE, size);
+	
+	ByteBuffer bb(buf, size);
+	size_t needed;
+	
+	ParseResult result = OperationReply::peekSize(&bb, &needed);
+	if (result != PR_SUCCESS && result != PR_BUFFER)
+		return trace.exit(S6M_Error_FromParseResult(result));
+	return trace.exit(needed);
+}
+
 void S6M_OpReply_free(S6M_OpReply *opReply)
 {
+	CallTrace trace(TC_OP_REPLY_FREE);
+	
 	delete (S6M_OpReplyExtended *)opReply;
 }
 
@@ -506,21 +846,25 @@ struct S6M_PasswdReqExtended: public S6M_PasswdReq
 
 ssize_t S6M_PasswdReq_packedSize(const S6M_PasswdReq *pwReq)
 {
+	CallTrace trace(TC_PASSWD_REQ_PACKED_SIZE);
+	
 	S6M_Error err;
 	
 	try
 	{
 		UserPasswordRequest req({ pwReq->username, pwReq->passwd });
 		
-		return req.packedSize();
+		return trace.exit(req.packedSize());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_PasswdReq_pack(const S6M_PasswdReq *pwReq, uint8_t *buf, size_t size)
 {
+	CallTrace trace(TC_PASSWD_REQ_PACK, size);
+	
 	S6M_Error err;
 	
 	try
@@ -530,26 +874,31 @@ ssize_t S6M_PasswdReq_pack(const S6M_PasswdReq *pwReq, uint8_t *buf, size_t size
 		UserPasswordRequest req({ pwReq->username, pwReq->passwd });
 		req.pack(&bb);
 		
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_PasswdReq_parse(uint8_t *buf, size_t size, S6M_PasswdReq **ppwReq)
 {
+	CallTrace trace(TC_PASSWD_REQ_PARSE, size);
+	
 	S6M_Error err;
 	
 	try
 	{
 		ByteBuffer bb(buf, size);
-		UserPasswordRequest cppReq(&bb);
+		pair<string_view, string_view> creds;
+		ParseResult result = UserPasswordRequest::parseCredentials(&bb, &creds);
+		if (result != PR_SUCCESS)
+			return trace.exit(S6M_Error_FromParseResult(result));
 		
 		S6M_PasswdReqExtended *pwReq = new S6M_PasswdReqExtended();
 		try
 		{
-			auto [user, passwd] = cppReq.getCredentials();
+			auto [user, passwd] = creds;
 			pwReq->clutter.username = user;
 			pwReq->clutter.passwd   = passwd;
 		}
@@ -563,15 +912,17 @@ ssize_t S6M_PasswdReq_parse(uint8_t *buf, size_t size, S6M_PasswdReq **ppwReq)
 		pwReq->passwd   = pwReq->clutter.passwd.c_str();
 		
 		*ppwReq = pwReq;
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 void S6M_PasswdReq_free(S6M_PasswdReq *pwReq)
 {
+	CallTrace trace(TC_PASSWD_REQ_FREE);
+	
 	delete (S6M_PasswdReqExtended *)pwReq;
 }
 
@@ -581,13 +932,17 @@ void S6M_PasswdReq_free(S6M_PasswdReq *pwReq)
 
 ssize_t S6M_PasswdReply_packedSize(const S6M_PasswdReply *pwReply)
 {
+	CallTrace trace(TC_PASSWD_REPLY_PACKED_SIZE);
+	
 	(void)pwReply;
 	
-	return UserPasswordReply::packedSize();
+	return trace.exit(UserPasswordReply::packedSize());
 }
 
 ssize_t S6M_PasswdReply_pack(const S6M_PasswdReply *pwReply, uint8_t *buf, size_t size)
 {
+	CallTrace trace(TC_PASSWD_REPLY_PACK, size);
+	
 	S6M_Error err;
 	
 	try
@@ -597,44 +952,90 @@ ssize_t S6M_PasswdReply_pack(const S6M_PasswdReply *pwReply, uint8_t *buf, size_
 		UserPasswordReply rep(pwReply->success);
 		rep.pack(&bb);
 		
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 ssize_t S6M_PasswdReply_parse(uint8_t *buf, size_t size, S6M_PasswdReply **ppwReply)
 {
+	CallTrace trace(TC_PASSWD_REPLY_PARSE, size);
+	
 	S6M_Error err;
 	
 	try
 	{
 		ByteBuffer bb(buf, size);
-		UserPasswordReply rep(&bb);
+		UserPasswordReply rep(false);
+		ParseResult result = UserPasswordReply::parse(&bb, &rep);
+		if (result != PR_SUCCESS)
+			return trace.exit(S6M_Error_FromParseResult(result));
 		
 		S6M_PasswdReply *pwReply = new S6M_PasswdReply();
 		pwReply->success = rep.success;
 		
 		*ppwReply = pwReply;
-		return bb.getUsed();
+		return trace.exit(bb.getUsed());
 	}
 	S6M_CATCH(err);
 	
-	return err;
+	return trace.exit(err);
 }
 
 void S6M_PasswdReply_free(S6M_PasswdReply *pwReply)
 {
+	CallTrace trace(TC_PASSWD_REPLY_FREE);
+	
 	delete pwReply;
 }
 
+/*
+ * S6M_Stats_*
+ */
+
+static_assert((int)S6M_STATS_MESSAGES == (int)ParseStats::MESSAGES, "Message types out of sync");
+static_assert((int)S6M_STATS_DROPS == (int)ParseStats::DROPS, "Drop reasons out of sync");
+static_assert(S6M_STATS_KINDS == ParseStats::KIND_SLOTS, "Option kinds out of sync");
+/* ParseResult doubles as -S6M_Error */
+static_assert(S6M_STATS_ERRORS == ParseStats::RESULTS, "Errors out of sync");
+static_assert(-S6M_ERR_ADDRTYPE == PR_ADDRTYPE, "Errors out of sync");
+
+void S6M_Stats_enable(int enable)
+{
+	CallTrace trace(TC_STATS_ENABLE);
+	
+	ParseStats::enable(enable);
+}
+
+void S6M_Stats_snapshot(S6M_Stats *stats)
+{
+	CallTrace trace(TC_STATS_SNAPSHOT);
+	
+	ParseStats::Totals totals = ParseStats::snapshot();
+	
+	memset(stats, 0, sizeof(S6M_Stats));
+	for (int i = 0; i < S6M_STATS_MESSAGES; i++)
+	{
+		for (int j = 0; j < S6M_STATS_ERRORS; j++)
+		{
+			stats->messages[i][j] = totals.messages[i][j];
+			stats->errors[j] += totals.messages[i][j];
+		}
+	}
+	memcpy(stats->options, totals.options, sizeof(stats->options));
+	memcpy(stats->dropped, totals.drops, sizeof(stats->dropped));
+}
+
 /*
  * S6M_Error_*
  */
 
 const char *S6M_Error_msg(S6M_Error err)
 {
+	CallTrace trace(TC_ERROR_MSG);
+	
 	switch (err)
 	{
 	case S6M_ERR_SUCCESS:
@@ -30,30 +30,138 @@ void Address::pack(ByteBuffer *bb)  const
 	}
 }
 
+void Address::pack(GatherBuffer *gb) const
+{
+	if (type != SOCKS6_ADDR_DOMAIN)
+	{
+		pack(static_cast<ByteBuffer *>(gb));
+		return;
+	}
+	
+	string_view domain = getDomain();
+	*gb->get<uint8_t>() = domain.length();
+	gb->append(reinterpret_cast<const uint8_t *>(domain.data()), domain.length());
+	
+	size_t padding = paddingOf(1 + domain.length());
+	memset(gb->get<uint8_t>(padding), 0, padding);
+}
+
 Address::Address(SOCKS6AddressType type, ByteBuffer *bb)
-	: type(type)
+{
+	enforceParseResult(parse(type, bb, this), bb);
+}
+
+template <typename BUFFER>
+ParseResult Address::parse(SOCKS6AddressType type, BUFFER *bb, Address *addr) noexcept
+{
+	AddressView view;
+	ParseResult result = AddressView::parse(type, bb, &view);
+	if (result != PR_SUCCESS)
+		return result;
+	
+	try
+	{
+		addr->assign(view);
+	}
+	catch (bad_alloc &)
+	{
+		return PR_ALLOC;
+	}
+	return PR_SUCCESS;
+}
+
+AddressView::AddressView(const Address &addr)
+	: type(addr.getType())
 {
 	switch (type)
 	{
 	case SOCKS6_ADDR_IPV4:
-	{
-		u = *bb->get<in_addr>();
+		u = addr.getIPv4();
+		break;
+		
+	case SOCKS6_ADDR_IPV6:
+		u = addr.getIPv6();
+		break;
+		
+	case SOCKS6_ADDR_DOMAIN:
+		u = addr.getDomain();
 		break;
 	}
+}
+
+template <typename BUFFER>
+ParseResult AddressView::parse(SOCKS6AddressType type, BUFFER *bb, AddressView *addr) noexcept
+{
+	switch (type)
+	{
+	case SOCKS6_ADDR_IPV4:
+	{
+		in_addr *rawIPv4 = bb->template tryGet<in_addr>();
+		if (!rawIPv4)
+			return PR_BUFFER;
+		addr->type = type;
+		addr->u = *rawIPv4;
+		return PR_SUCCESS;
+	}
 		
 	case SOCKS6_ADDR_IPV6:
 	{
-		u = *bb->get<in6_addr>();
-		break;
+		in6_addr *rawIPv6 = bb->template tryGet<in6_addr>();
+		if (!rawIPv6)
+			return PR_BUFFER;
+		addr->type = type;
+		addr->u = *rawIPv6;
+		return PR_SUCCESS;
 	}
 		
 	case SOCKS6_ADDR_DOMAIN:
-		u = Padded<String>(bb);
-		break;
+	{
+		string_view domain;
+		ParseResult result = String::parse(bb, &domain);
+		if (result != PR_SUCCESS)
+			return result;
+		if (!bb->trySkip(paddingOf(1 + domain.length())))
+			return PR_BUFFER;
+		addr->type = type;
+		addr->u = domain;
+		return PR_SUCCESS;
+	}
+	}
+	
+	return PR_ADDRTYPE;
+}
 
-	default:
-		throw BadAddressTypeException();
+ParseResult Address::peekSize(SOCKS6AddressType type, ByteBuffer *bb, size_t *size) noexcept
+{
+	switch (type)
+	{
+	case SOCKS6_ADDR_IPV4:
+		*size = sizeof(in_addr);
+		return PR_SUCCESS;
+		
+	case SOCKS6_ADDR_IPV6:
+		*size = sizeof(in6_addr);
+		return PR_SUCCESS;
+		
+	case SOCKS6_ADDR_DOMAIN:
+	{
+		uint8_t *len = bb->tryPeek<uint8_t>();
+		if (!len)
+		{
+			*size = 1;
+			return PR_BUFFER;
+		}
+		*size = 1 + *len + paddingOf(1 + *len);
+		return PR_SUCCESS;
 	}
+	}
+	
+	return PR_ADDRTYPE;
 }
 
+template ParseResult Address::parse(SOCKS6AddressType type, ByteBuffer *bb, Address *addr) noexcept;
+template ParseResult Address::parse(SOCKS6AddressType type, ScatterBuffer *bb, Address *addr) noexcept;
+template ParseResult AddressView::parse(SOCKS6AddressType type, ByteBuffer *bb, AddressView *addr) noexcept;
+template ParseResult AddressView::parse(SOCKS6AddressType type, ScatterBuffer *bb, AddressView *addr) noexcept;
+
 }
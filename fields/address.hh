@@ -7,21 +7,118 @@
 #include <vector>
 #include <optional>
 #include <variant>
+#include <memory_resource>
 #include "socks6.h"
 #include "bytebuffer.hh"
 #include "string.hh"
 #include "padded.hh"
 #include "exceptions.hh"
+#include "gatherbuffer.hh"
+#include "scatterbuffer.hh"
 
 namespace S6M
 {
 
+class Address;
+
+/*
+ * Parsed address that leaves the domain in the buffer it was parsed from.
+ */
+class AddressView
+{
+	SOCKS6AddressType type = SOCKS6_ADDR_IPV4;
+	
+	std::variant<in_addr, in6_addr, std::string_view> u = in_addr({ 0 });
+	
+public:
+	AddressView() = default;
+	
+	AddressView(in_addr ipv4)
+		: type(SOCKS6_ADDR_IPV4), u(ipv4) {}
+	
+	AddressView(in6_addr ipv6)
+		: type(SOCKS6_ADDR_IPV6), u(ipv6) {}
+	
+	/* the domain stays in addr */
+	AddressView(const Address &addr);
+	
+	template <typename BUFFER>
+	static ParseResult parse(SOCKS6AddressType type, BUFFER *bb, AddressView *addr) noexcept;
+	
+	size_t packedSize() const
+	{
+		switch (type)
+		{
+		case SOCKS6_ADDR_IPV4:
+			return sizeof(in_addr);
+			
+		case SOCKS6_ADDR_IPV6:
+			return sizeof(in6_addr);
+			
+		case SOCKS6_ADDR_DOMAIN:
+		{
+			size_t size = 1 + std::get<std::string_view>(u).length();
+			return size + paddingOf(size);
+		}
+		}
+		
+		/* never happens */
+		assert(false);
+		return 0;
+	}
+	
+	SOCKS6AddressType getType() const
+	{
+		return type;
+	}
+	
+	in_addr getIPv4() const
+	{
+		return std::get<in_addr>(u);
+	}
+	
+	in6_addr getIPv6() const
+	{
+		return std::get<in6_addr>(u);
+	}
+	
+	std::string_view getDomain() const
+	{
+		return std::get<std::string_view>(u);
+	}
+};
+
 class Address
 {
 	SOCKS6AddressType type = SOCKS6_ADDR_IPV4;
 	
 	std::variant<in_addr, in6_addr, Padded<String>> u = in_addr({ 0 });
 	
+	/* where the domain goes; kept across assignments, like any pmr container */
+	std::pmr::memory_resource *resource = std::pmr::get_default_resource();
+	
+	/* ADDR is Address or AddressView */
+	template <typename ADDR>
+	void assign(const ADDR &other)
+	{
+		type = other.getType();
+		
+		switch (type)
+		{
+		case SOCKS6_ADDR_IPV4:
+			u = other.getIPv4();
+			break;
+			
+		case SOCKS6_ADDR_IPV6:
+			u = other.getIPv6();
+			break;
+			
+		case SOCKS6_ADDR_DOMAIN:
+			u.template emplace<Padded<String>>(other.getDomain(), resource);
+			break;
+		}
+	}
+	
 public:
 	size_t packedSize() const
 	{
@@ -44,6 +141,9 @@ public:
 	
 	void pack(ByteBuffer *bb) const;
 	
+	/* references the domain */
+	void pack(GatherBuffer *gb) const;
+	
 	Address() = default;
 	
 	Address(in_addr ipv4)
@@ -52,11 +152,52 @@ public:
 	Address(in6_addr ipv6)
 		: type(SOCKS6_ADDR_IPV6), u(ipv6) {}
 	
-	Address(const std::string_view &domain)
-		: type(SOCKS6_ADDR_DOMAIN), u(domain) {}
+	Address(const std::string_view &domain, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: type(SOCKS6_ADDR_DOMAIN), u(std::in_place_type<Padded<String>>, domain, resource), resource(resource) {}
+	
+	Address(const AddressView &view, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: resource(resource)
+	{
+		assign(view);
+	}
+	
+	Address(const Address &other, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: resource(resource)
+	{
+		assign(other);
+	}
+	
+	Address(Address &&other) = default;
 	
 	Address(SOCKS6AddressType type, ByteBuffer *bb);
 	
+	Address &operator =(const Address &other)
+	{
+		if (this != &other)
+			assign(other);
+		return *this;
+	}
+	
+	/* copies unless both use the same resource */
+	Address &operator =(Address &&other)
+	{
+		if (resource != other.resource)
+			return *this = (const Address &)other;
+		
+		type = other.type;
+		u = std::move(other.u);
+		return *this;
+	}
+	
+	template <typename BUFFER>
+	static ParseResult parse(SOCKS6AddressType type, BUFFER *bb, Address *addr) noexcept;
+	
+	/*
+	 * Works out the packed size of the address at the start of bb.
+	 * PR_BUFFER: *size bytes are needed to tell.
+	 */
+	static ParseResult peekSize(SOCKS6AddressType type, ByteBuffer *bb, size_t *size) noexcept;
+	
 	SOCKS6AddressType getType() const
 	{
 		return type;
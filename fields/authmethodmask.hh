@@ -0,0 +1,199 @@
+#ifndef SOCKS6MSG_AUTHMETHODMASK_HH
+#define SOCKS6MSG_AUTHMETHODMASK_HH
+
+#include <stdint.h>
+#include <stddef.h>
+#include <iterator>
+#include <initializer_list>
+#include "socks6.h"
+#include "span.hh"
+
+namespace S6M
+{
+
+/**
+ * @brief Set of authentication methods
+ * One bit per method, so it never allocates. Iterates in method order.
+ */
+class AuthMethodMask
+{
+	static constexpr int WORD_BITS = 64;
+	static constexpr int WORDS     = 256 / WORD_BITS;
+
+	uint64_t words[WORDS] = { 0 };
+
+	static constexpr uint64_t bit(uint8_t method)
+	{
+		return (uint64_t)1 << (method % WORD_BITS);
+	}
+
+	/* first method >= from, or 256 */
+	int next(int from) const
+	{
+		for (int i = from / WORD_BITS; i < WORDS; i++)
+		{
+			uint64_t word = words[i];
+			if (i == from / WORD_BITS)
+				word &= ~(uint64_t)0 << (from % WORD_BITS);
+			if (word)
+				return i * WORD_BITS + __builtin_ctzll(word);
+		}
+		return WORDS * WORD_BITS;
+	}
+
+public:
+	class Iterator
+	{
+		const AuthMethodMask *mask;
+		int method;
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef SOCKS6Method              value_type;
+		typedef ptrdiff_t                 difference_type;
+		typedef const SOCKS6Method       *pointer;
+		typedef SOCKS6Method              reference;
+
+		Iterator(const AuthMethodMask *mask, int method)
+			: mask(mask), method(method) {}
+
+		SOCKS6Method operator *() const
+		{
+			return (SOCKS6Method)method;
+		}
+
+		Iterator &operator ++()
+		{
+			method = mask->next(method + 1);
+			return *this;
+		}
+
+		Iterator operator ++(int)
+		{
+			Iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator ==(const Iterator &other) const
+		{
+			return method == other.method;
+		}
+
+		bool operator !=(const Iterator &other) const
+		{
+			return method != other.method;
+		}
+	};
+
+	AuthMethodMask() = default;
+
+	AuthMethodMask(std::initializer_list<SOCKS6Method> methods)
+	{
+		for (SOCKS6Method method: methods)
+			insert(method);
+	}
+
+	/* raw methods, as found in an advertisement; duplicates are fine */
+	explicit AuthMethodMask(Span<const uint8_t> methods)
+	{
+		for (uint8_t method: methods)
+			insert((SOCKS6Method)method);
+	}
+
+	void insert(SOCKS6Method method)
+	{
+		words[method / WORD_BITS] |= bit(method);
+	}
+
+	void erase(SOCKS6Method method)
+	{
+		words[method / WORD_BITS] &= ~bit(method);
+	}
+
+	bool contains(SOCKS6Method method) const
+	{
+		return words[method / WORD_BITS] & bit(method);
+	}
+
+	size_t size() const
+	{
+		size_t count = 0;
+		for (uint64_t word: words)
+			count += __builtin_popcountll(word);
+		return count;
+	}
+
+	bool empty() const
+	{
+		uint64_t all = 0;
+		for (uint64_t word: words)
+			all |= word;
+		return all == 0;
+	}
+
+	/* lowest method, or SOCKS6_METHOD_UNACCEPTABLE if empty */
+	SOCKS6Method first() const
+	{
+		int method = next(0);
+		if (method == WORDS * WORD_BITS)
+			return SOCKS6_METHOD_UNACCEPTABLE;
+		return (SOCKS6Method)method;
+	}
+
+	Iterator begin() const
+	{
+		return Iterator(this, next(0));
+	}
+
+	Iterator end() const
+	{
+		return Iterator(this, WORDS * WORD_BITS);
+	}
+
+	/* e.g. advertised methods & server policy */
+	AuthMethodMask operator &(const AuthMethodMask &other) const
+	{
+		AuthMethodMask result;
+		for (int i = 0; i < WORDS; i++)
+			result.words[i] = words[i] & other.words[i];
+		return result;
+	}
+
+	AuthMethodMask operator |(const AuthMethodMask &other) const
+	{
+		AuthMethodMask result;
+		for (int i = 0; i < WORDS; i++)
+			result.words[i] = words[i] | other.words[i];
+		return result;
+	}
+
+	AuthMethodMask &operator &=(const AuthMethodMask &other)
+	{
+		return *this = *this & other;
+	}
+
+	AuthMethodMask &operator |=(const AuthMethodMask &other)
+	{
+		return *this = *this | other;
+	}
+
+	bool operator ==(const AuthMethodMask &other) const
+	{
+		for (int i = 0; i < WORDS; i++)
+		{
+			if (words[i] != other.words[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool operator !=(const AuthMethodMask &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_AUTHMETHODMASK_HH
@@ -5,14 +5,16 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include "bytebuffer.hh"
+#include "parseresult.hh"
 
 namespace S6M
 {
 
 class String
 {
-	std::string str;
+	std::pmr::string str;
 	
 	void sanity()
 	{
@@ -25,20 +27,40 @@ class String
 	}
 	
 public:
-	String(const std::string_view &str)
-		: str(str)
+	String(const std::string_view &str, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: str(str, resource)
 	{
 		sanity();
 	}
 	
-	String(ByteBuffer *bb)
+	String(ByteBuffer *bb, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: str(resource)
 	{
-		uint8_t *len    = bb->get<uint8_t>();
-		uint8_t *rawStr = bb->get<uint8_t>(*len);
+		std::string_view view;
 		
-		str = std::move(std::string(reinterpret_cast<const char *>(rawStr), (size_t)*len));
+		enforceParseResult(parse(bb, &view), bb);
+		str = view;
+	}
+	
+	/* view points into bb */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, std::string_view *view) noexcept
+	{
+		uint8_t *len = bb->template tryGet<uint8_t>();
+		if (!len)
+			return PR_BUFFER;
 		
-		sanity();
+		uint8_t *rawStr = bb->template tryGet<uint8_t>(*len);
+		if (!rawStr)
+			return PR_BUFFER;
+		
+		if (*len == 0)
+			return PR_INVALID;
+		if (memchr(rawStr, '\0', *len) != nullptr)
+			return PR_INVALID;
+		
+		*view = std::string_view(reinterpret_cast<const char *>(rawStr), *len);
+		return PR_SUCCESS;
 	}
 	
 	size_t packedSize() const
@@ -2,6 +2,7 @@
 #define SOCKS6MSG_VERSIONCHECKER_HH
 
 #include "bytebuffer.hh"
+#include "parseresult.hh"
 
 namespace S6M
 {
@@ -17,6 +18,17 @@ struct VersionChecker
 		if (*ver != VER)
 			throw BadVersionException(*ver);
 	}
+	
+	template <typename BUFFER>
+	static ParseResult check(BUFFER *bb) noexcept
+	{
+		uint8_t *ver = bb->template tryPeek<uint8_t>();
+		if (!ver)
+			return PR_BUFFER;
+		if (*ver != VER)
+			return PR_OTHERVER;
+		return PR_SUCCESS;
+	}
 };
 
 }
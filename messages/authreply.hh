@@ -3,6 +3,7 @@
 
 #include "messagebase.hh"
 #include "optionset.hh"
+#include "sanity.hh"
 
 namespace S6M
 {
@@ -11,25 +12,93 @@ struct AuthenticationReply: public MessageBase<SOCKS6_VERSION, SOCKS6AuthReply>
 {
 	Enum<SOCKS6AuthReplyCode> code { SOCKS6_AUTH_REPLY_SUCCESS };
 
-	OptionSet options { OptionSet::M_AUTH_REP };
+	OptionSet options;
 
-	AuthenticationReply(SOCKS6AuthReplyCode replyCode)
-		: code(replyCode) {}
+	/* variable-length options are allocated from resource */
+	AuthenticationReply(SOCKS6AuthReplyCode replyCode, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: code(replyCode), options(OptionSet::M_AUTH_REP, resource) {}
 	
-	AuthenticationReply(ByteBuffer *bb)
-		: MessageBase(bb),
-		  code(rawMessage->type),
-		  options(bb, OptionSet::M_AUTH_REP, ntohs(rawMessage->optionsLength)) {}
+	AuthenticationReply(ByteBuffer *bb, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: AuthenticationReply(SOCKS6_AUTH_REPLY_SUCCESS, resource)
+	{
+		enforceParseResult(parse(bb, this), bb);
+	}
+	
+	/*
+	 * Expects a freshly constructed authReply; its contents are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, AuthenticationReply *authReply) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::AUTH_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		BUFFER tmpBB(*bb);
+		SOCKS6AuthReply *rawAuthReply;
+		
+		ParseResult result = parseHead(&tmpBB, &rawAuthReply);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::AUTH_REPLY, &tmpBB, result);
+		
+		if (!enumValid<SOCKS6AuthReplyCode>(rawAuthReply->type))
+			return parseExit(ParseStats::AUTH_REPLY, &tmpBB, PR_INVALID);
+		authReply->code = rawAuthReply->type;
+		
+		result = authReply->options.parse(&tmpBB, ntohs(rawAuthReply->optionsLength));
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::AUTH_REPLY, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::AUTH_REPLY, &tmpBB, PR_SUCCESS);
+	}
+	
+	/*
+	 * Works out the size of the message at the start of bb from its first bytes.
+	 * PR_SUCCESS: *size is the size of the whole message.
+	 * PR_BUFFER: *size bytes are needed to tell.
+	 */
+	static ParseResult peekSize(ByteBuffer *bb, size_t *size) noexcept
+	{
+		ByteBuffer tmpBB(*bb);
+		SOCKS6AuthReply *rawAuthReply;
+		
+		*size = sizeof(SOCKS6AuthReply);
+		ParseResult result = parseHead(&tmpBB, &rawAuthReply);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		uint16_t optionsLength = ntohs(rawAuthReply->optionsLength);
+		*size += optionsLength;
+		return OptionSet::checkLength(optionsLength);
+	}
 	
 	void pack(ByteBuffer *bb) const
 	{
+		S6M_PROBE(pack_entry, ParseStats::AUTH_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		size_t start = bb->getUsed();
 		SOCKS6AuthReply *rawAuthReply = bb->get<SOCKS6AuthReply>();
 		
 		rawAuthReply->version       = SOCKS6_VERSION;
 		rawAuthReply->type          = code;
-		rawAuthReply->optionsLength = htons(options.packedSize());
 		
+		size_t optionsStart = bb->getUsed();
 		options.pack(bb);
+		/* known once the options are in */
+		rawAuthReply->optionsLength = htons(bb->getUsed() - optionsStart);
+		S6M_PROBE(pack_return, ParseStats::AUTH_REPLY, bb->getUsed() - start, 0);
+	}
+	
+	/* large fields are referenced, not copied; gb->finish() once done */
+	void pack(GatherBuffer *gb) const
+	{
+		SOCKS6AuthReply *rawAuthReply = gb->get<SOCKS6AuthReply>();
+		
+		rawAuthReply->version       = SOCKS6_VERSION;
+		rawAuthReply->type          = code;
+		
+		size_t optionsStart = gb->getTotalSize();
+		options.pack(gb);
+		/* known once the options are in */
+		rawAuthReply->optionsLength = htons(gb->getTotalSize() - optionsStart);
 	}
 	
 	size_t pack(uint8_t *buf, size_t bufSize) const
@@ -39,12 +108,26 @@ struct AuthenticationReply: public MessageBase<SOCKS6_VERSION, SOCKS6AuthReply>
 		return bb.getUsed();
 	}
 	
+	/* appends the message to out */
+	size_t pack(std::vector<uint8_t> *out) const
+	{
+		size_t offset = out->size();
+		out->resize(offset + packedSize());
+		
+		ByteBuffer bb(out->data() + offset, out->size() - offset);
+		pack(&bb);
+		return bb.getUsed();
+	}
+	
 	size_t packedSize() const
 	{
 		return sizeof(SOCKS6AuthReply) + options.packedSize();
 	}
 };
 
+/* messages are meant to live on the stack */
+static_assert(sizeof(AuthenticationReply) <= 384, "AuthenticationReply outgrew its size budget");
+
 }
 
 #endif // SOCKS6MSG_AUTHREPLY_HH
@@ -0,0 +1,55 @@
+#ifndef SOCKS6MSG_AUTHREPLYVIEW_HH
+#define SOCKS6MSG_AUTHREPLYVIEW_HH
+
+#include "authreply.hh"
+#include "optionsetview.hh"
+
+namespace S6M
+{
+
+/*
+ * AuthenticationReply that points into the buffer it was parsed from.
+ * The buffer must outlive the view; parsing allocates nothing.
+ */
+struct AuthenticationReplyView: public MessageBase<SOCKS6_VERSION, SOCKS6AuthReply>
+{
+	SOCKS6AuthReplyCode code = SOCKS6_AUTH_REPLY_SUCCESS;
+	
+	OptionSetView options { OptionSetBase::M_AUTH_REP };
+	
+	/*
+	 * Expects a freshly constructed authReply; its contents are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, AuthenticationReplyView *authReply) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::AUTH_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		BUFFER tmpBB(*bb);
+		SOCKS6AuthReply *rawAuthReply;
+		
+		ParseResult result = parseHead(&tmpBB, &rawAuthReply);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::AUTH_REPLY, &tmpBB, result);
+		
+		if (!enumValid<SOCKS6AuthReplyCode>(rawAuthReply->type))
+			return parseExit(ParseStats::AUTH_REPLY, &tmpBB, PR_INVALID);
+		authReply->code = (SOCKS6AuthReplyCode)rawAuthReply->type;
+		
+		result = authReply->options.parse(&tmpBB, ntohs(rawAuthReply->optionsLength));
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::AUTH_REPLY, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::AUTH_REPLY, &tmpBB, PR_SUCCESS);
+	}
+	
+	static ParseResult peekSize(ByteBuffer *bb, size_t *size) noexcept
+	{
+		return AuthenticationReply::peekSize(bb, size);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_AUTHREPLYVIEW_HH
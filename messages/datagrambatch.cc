@@ -0,0 +1,143 @@
+#include <algorithm>
+#include "datagrambatch.hh"
+
+using namespace std;
+
+namespace S6M
+{
+
+void DatagramBatch::parseOne(size_t i, uint8_t *buf, size_t size) noexcept
+{
+	ByteBuffer bb(buf, size);
+	
+	result[i] = VersionChecker<SOCKS6_VERSION>::check(&bb);
+	if (result[i] != PR_SUCCESS)
+		return;
+	
+	SOCKS6DatagramHeader *rawHeader = bb.tryGet<SOCKS6DatagramHeader>();
+	if (!rawHeader)
+	{
+		result[i] = PR_BUFFER;
+		return;
+	}
+	
+	assocID[i] = be64toh(rawHeader->assocID);
+	port[i]    = ntohs(rawHeader->port);
+	
+	result[i] = AddressView::parse((SOCKS6AddressType)rawHeader->addressType, &bb, &address[i]);
+	payloadOffset[i] = bb.getUsed();
+}
+
+size_t DatagramBatch::parse(const iovec *datagrams, size_t datagramCount) noexcept
+{
+	count = min(datagramCount, MAX);
+	
+	size_t parsed = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		parseOne(i, reinterpret_cast<uint8_t *>(datagrams[i].iov_base), datagrams[i].iov_len);
+		parsed += result[i] == PR_SUCCESS;
+	}
+	return parsed;
+}
+
+size_t DatagramBatch::parse(const mmsghdr *msgs, size_t msgCount) noexcept
+{
+	count = min(msgCount, MAX);
+	
+	size_t parsed = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const msghdr *hdr = &msgs[i].msg_hdr;
+		if (hdr->msg_iovlen == 0)
+		{
+			result[i] = PR_BUFFER;
+			continue;
+		}
+		
+		parseOne(i, reinterpret_cast<uint8_t *>(hdr->msg_iov[0].iov_base), min((size_t)msgs[i].msg_len, hdr->msg_iov[0].iov_len));
+		parsed += result[i] == PR_SUCCESS;
+	}
+	return parsed;
+}
+
+void DatagramBatch::packOne(size_t i, iovec *header) noexcept
+{
+	/* straight into the buffer: sizes are checked once, up front */
+	const AddressView &addr = address[i];
+	size_t addrSize = addr.packedSize();
+	size_t size = sizeof(SOCKS6DatagramHeader) + addrSize;
+	if (size > header->iov_len)
+	{
+		result[i] = PR_BUFFER;
+		return;
+	}
+	
+	SOCKS6DatagramHeader *rawHeader = reinterpret_cast<SOCKS6DatagramHeader *>(header->iov_base);
+	rawHeader->version     = SOCKS6_VERSION;
+	rawHeader->addressType = addr.getType();
+	rawHeader->port        = htons(port[i]);
+	rawHeader->assocID     = htobe64(assocID[i]);
+	
+	uint8_t *rawAddr = rawHeader->address;
+	switch (addr.getType())
+	{
+	case SOCKS6_ADDR_IPV4:
+	{
+		in_addr ipv4 = addr.getIPv4();
+		memcpy(rawAddr, &ipv4, sizeof(ipv4));
+		break;
+	}
+		
+	case SOCKS6_ADDR_IPV6:
+	{
+		in6_addr ipv6 = addr.getIPv6();
+		memcpy(rawAddr, &ipv6, sizeof(ipv6));
+		break;
+	}
+		
+	case SOCKS6_ADDR_DOMAIN:
+	{
+		string_view domain = addr.getDomain();
+		rawAddr[0] = domain.length();
+		memcpy(rawAddr + 1, domain.data(), domain.length());
+		memset(rawAddr + 1 + domain.length(), 0, addrSize - 1 - domain.length());
+		break;
+	}
+	}
+	
+	header->iov_len  = size;
+	payloadOffset[i] = size;
+	result[i]        = PR_SUCCESS;
+}
+
+size_t DatagramBatch::pack(iovec *headers) noexcept
+{
+	size_t packed = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		packOne(i, &headers[i]);
+		packed += result[i] == PR_SUCCESS;
+	}
+	return packed;
+}
+
+size_t DatagramBatch::pack(mmsghdr *msgs) noexcept
+{
+	size_t packed = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		msghdr *hdr = &msgs[i].msg_hdr;
+		if (hdr->msg_iovlen == 0)
+		{
+			result[i] = PR_BUFFER;
+			continue;
+		}
+		
+		packOne(i, &hdr->msg_iov[0]);
+		packed += result[i] == PR_SUCCESS;
+	}
+	return packed;
+}
+
+}
@@ -0,0 +1,56 @@
+#ifndef SOCKS6MSG_DATAGRAMBATCH_HH
+#define SOCKS6MSG_DATAGRAMBATCH_HH
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "datagramheader.hh"
+
+namespace S6M
+{
+
+/*
+ * Datagram headers of a recvmmsg()/sendmmsg() burst, handled in one call.
+ * Fields are kept one array per field, indexed by packet.
+ * Parsed domains point into the received buffers, like AddressView.
+ */
+struct DatagramBatch
+{
+	static constexpr size_t MAX = 64;
+	
+	size_t count = 0;
+	
+	ParseResult result[MAX];
+	uint64_t    assocID[MAX];
+	AddressView address[MAX];
+	uint16_t    port[MAX];
+	/* where the payload starts within the datagram, i.e. the size of the header */
+	uint16_t    payloadOffset[MAX];
+	
+	/*
+	 * Parses the header at the start of each datagram; at most MAX are looked at.
+	 * A bad datagram only fails its own result. Returns how many parsed successfully.
+	 */
+	size_t parse(const iovec *datagrams, size_t datagramCount) noexcept;
+	
+	/* as filled in by recvmmsg(): the header is expected in the first iovec, msg_len bytes long at most */
+	size_t parse(const mmsghdr *msgs, size_t msgCount) noexcept;
+	
+	/*
+	 * Packs the first count headers, each at the start of headers[i].
+	 * iov_len is the room available on the way in and the header size on the way out.
+	 * PR_BUFFER if a header does not fit; that iovec is left alone. Returns how many were packed.
+	 */
+	size_t pack(iovec *headers) noexcept;
+	
+	/* headers go into the first iovec of each message, for sendmmsg() */
+	size_t pack(mmsghdr *msgs) noexcept;
+	
+private:
+	void parseOne(size_t i, uint8_t *buf, size_t size) noexcept;
+	
+	void packOne(size_t i, iovec *header) noexcept;
+};
+
+}
+
+#endif // SOCKS6MSG_DATAGRAMBATCH_HH
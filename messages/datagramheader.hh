@@ -17,13 +17,40 @@ struct DatagramHeader: public MessageBase<SOCKS6_VERSION, SOCKS6DatagramHeader>
 		: assocID(assocID), address(address), port(port) {}
 
 	DatagramHeader(ByteBuffer *bb)
-		: MessageBase(bb),
-		  assocID(be64toh(rawMessage->assocID)),
-		  address((SOCKS6AddressType)rawMessage->addressType, bb),
-		  port(ntohs(rawMessage->port)) {}
+		: DatagramHeader((uint64_t)0)
+	{
+		enforceParseResult(parse(bb, this), bb);
+	}
+	
+	/*
+	 * Contents of header are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	static ParseResult parse(ByteBuffer *bb, DatagramHeader *header) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::DATAGRAM, bb->getTotalSize() - bb->getUsed(), 0);
+		ByteBuffer tmpBB(*bb);
+		SOCKS6DatagramHeader *rawHeader;
+		
+		ParseResult result = parseHead(&tmpBB, &rawHeader);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::DATAGRAM, &tmpBB, result);
+		
+		header->assocID = be64toh(rawHeader->assocID);
+		header->port    = ntohs(rawHeader->port);
+		
+		result = Address::parse((SOCKS6AddressType)rawHeader->addressType, &tmpBB, &header->address);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::DATAGRAM, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::DATAGRAM, &tmpBB, PR_SUCCESS);
+	}
 
 	void pack(ByteBuffer *bb) const
 	{
+		S6M_PROBE(pack_entry, ParseStats::DATAGRAM, bb->getTotalSize() - bb->getUsed(), 0);
+		size_t start = bb->getUsed();
 		SOCKS6DatagramHeader *rawHeader = bb->get<SOCKS6DatagramHeader>();
 		
 		rawHeader->version     = SOCKS6_VERSION;
@@ -32,6 +59,7 @@ struct DatagramHeader: public MessageBase<SOCKS6_VERSION, SOCKS6DatagramHeader>
 		rawHeader->assocID     = htobe64(assocID);
 		
 		address.pack(bb);
+		S6M_PROBE(pack_return, ParseStats::DATAGRAM, bb->getUsed() - start, 0);
 	}
 
 	size_t pack(uint8_t *buf, size_t bufSize) const
@@ -45,6 +73,57 @@ struct DatagramHeader: public MessageBase<SOCKS6_VERSION, SOCKS6DatagramHeader>
 	{
 		return sizeof(SOCKS6DatagramHeader) + address.packedSize();
 	}
+	
+	/* room for any header */
+	static constexpr size_t MAX_HEADROOM = sizeof(SOCKS6DatagramHeader) + 1 + 255 + paddingOf(1 + 255);
+	
+	/* most room a header with that type of address can take */
+	static constexpr size_t headroom(SOCKS6AddressType addressType)
+	{
+		switch (addressType)
+		{
+		case SOCKS6_ADDR_IPV4:
+			return sizeof(SOCKS6DatagramHeader) + sizeof(in_addr);
+			
+		case SOCKS6_ADDR_IPV6:
+			return sizeof(SOCKS6DatagramHeader) + sizeof(in6_addr);
+			
+		case SOCKS6_ADDR_DOMAIN:
+			return MAX_HEADROOM;
+		}
+		return 0;
+	}
+	
+	/*
+	 * Packs the header into the room bytes in front of payload, so that it ends where the payload begins.
+	 * Returns where the datagram starts. The payload is left alone.
+	 */
+	uint8_t *encapsulate(uint8_t *payload, size_t room) const
+	{
+		size_t size = packedSize();
+		if (size > room)
+			throw EndOfBufferException();
+		
+		uint8_t *start = payload - size;
+		pack(start, size);
+		return start;
+	}
+	
+	/*
+	 * Parses the header at the start of datagram; the payload starts at *payloadOffset and is left alone.
+	 * Contents of header are unspecified on failure.
+	 */
+	static ParseResult decapsulate(uint8_t *datagram, size_t size, DatagramHeader *header, size_t *payloadOffset) noexcept
+	{
+		ByteBuffer bb(datagram, size);
+		
+		ParseResult result = parse(&bb, header);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		*payloadOffset = bb.getUsed();
+		return PR_SUCCESS;
+	}
 };
 
 }
@@ -0,0 +1,87 @@
+#ifndef SOCKS6MSG_DATAGRAMPREFIX_HH
+#define SOCKS6MSG_DATAGRAMPREFIX_HH
+
+#include <string.h>
+#include <algorithm>
+#include <sys/uio.h>
+#include "datagramheader.hh"
+
+namespace S6M
+{
+
+/*
+ * Datagram header packed once, for an association that keeps sending to the same destination.
+ * Every datagram then gets it with a plain copy.
+ */
+class DatagramPrefix
+{
+	uint8_t  bytes[DatagramHeader::MAX_HEADROOM];
+	uint16_t size;
+	
+public:
+	DatagramPrefix(const DatagramHeader &header)
+		: size(header.pack(bytes, sizeof(bytes))) {}
+	
+	const uint8_t *getBytes() const
+	{
+		return bytes;
+	}
+	
+	size_t getSize() const
+	{
+		return size;
+	}
+	
+	size_t pack(uint8_t *buf, size_t bufSize) const
+	{
+		if (size > bufSize)
+			throw EndOfBufferException();
+		
+		memcpy(buf, bytes, size);
+		return size;
+	}
+	
+	/* like DatagramHeader::encapsulate() */
+	uint8_t *encapsulate(uint8_t *payload, size_t room) const
+	{
+		if (size > room)
+			throw EndOfBufferException();
+		
+		uint8_t *start = payload - size;
+		memcpy(start, bytes, size);
+		return start;
+	}
+	
+	/*
+	 * GSO (UDP_SEGMENT): the kernel cuts a super-packet into datagrams of segmentSize() bytes, the last one shorter.
+	 * Each of them needs the header, so segmentPayload bytes of payload go after each copy.
+	 */
+	size_t segmentSize(size_t segmentPayload) const
+	{
+		return size + segmentPayload;
+	}
+	
+	/*
+	 * Lays out the super-packet for sendmsg() without copying anything: every other iovec points at this prefix.
+	 * Needs 2 iovecs per segment; returns how many were used, or 0 if iovCount is too small.
+	 */
+	size_t gather(const uint8_t *payload, size_t payloadSize, size_t segmentPayload, iovec *iovs, size_t iovCount) const
+	{
+		size_t segments = (payloadSize + segmentPayload - 1) / segmentPayload;
+		if (segments * 2 > iovCount)
+			return 0;
+		
+		for (size_t i = 0; i < segments; i++)
+		{
+			size_t offset = i * segmentPayload;
+			
+			iovs[i * 2]     = { const_cast<uint8_t *>(bytes), size };
+			iovs[i * 2 + 1] = { const_cast<uint8_t *>(payload + offset), std::min(segmentPayload, payloadSize - offset) };
+		}
+		return segments * 2;
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_DATAGRAMPREFIX_HH
@@ -3,6 +3,8 @@
 
 #include "socks6.h"
 #include "versionchecker.hh"
+#include "parsestats.hh"
+#include "tracepoints.hh"
 
 namespace S6M
 {
@@ -19,6 +21,27 @@ protected:
 	
 	MessageBase(ByteBuffer *bb)
 		: versionChecker(bb), rawMessage(bb->get<RAW>()) {}
+	
+	template <typename BUFFER>
+	static ParseResult parseHead(BUFFER *bb, RAW **raw) noexcept
+	{
+		ParseResult result = VersionChecker<VER>::check(bb);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		*raw = bb->template tryGet<RAW>();
+		if (!*raw)
+			return PR_BUFFER;
+		return PR_SUCCESS;
+	}
+	
+	/* how parse functions return: counts the result and fires parse_return */
+	template <typename BUFFER>
+	static ParseResult parseExit(ParseStats::Message type, const BUFFER *tmpBB, ParseResult result) noexcept
+	{
+		S6M_PROBE(parse_return, type, tmpBB->getUsed(), result);
+		return ParseStats::message(type, result);
+	}
 };
 
 }
@@ -15,31 +15,110 @@ struct OperationReply: public MessageBase<SOCKS6_VERSION, SOCKS6OperationReply>
 	Address  address;
 	uint16_t port;
 	
-	OptionSet options { OptionSet::M_OP_REP };
+	OptionSet options;
 	
-	OperationReply(SOCKS6OperationReplyCode code, Address address = Address(), uint16_t port = 0)
-		: code(code), address(address), port(port) {}
+	/* the domain and variable-length options are allocated from resource */
+	OperationReply(SOCKS6OperationReplyCode code, const Address &address = Address(), uint16_t port = 0, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: code(code), address(address, resource), port(port), options(OptionSet::M_OP_REP, resource) {}
 	
-	OperationReply(ByteBuffer *bb)
-		: MessageBase(bb),
-		  code((SOCKS6OperationReplyCode)rawMessage->code),
-		  address((SOCKS6AddressType)rawMessage->addressType, bb),
-		  port(ntohs(rawMessage->bindPort)),
-		  options(bb, OptionSet::M_OP_REP, ntohs(rawMessage->optionsLength)) {}
+	OperationReply(ByteBuffer *bb, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: OperationReply(SOCKS6_OPERATION_REPLY_SUCCESS, Address(), 0, resource)
+	{
+		enforceParseResult(parse(bb, this), bb);
+	}
+	
+	/*
+	 * Expects a freshly constructed opReply; its contents are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, OperationReply *opReply) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::OP_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		BUFFER tmpBB(*bb);
+		SOCKS6OperationReply *rawOpReply;
+		
+		ParseResult result = parseHead(&tmpBB, &rawOpReply);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::OP_REPLY, &tmpBB, result);
+		
+		opReply->code = (SOCKS6OperationReplyCode)rawOpReply->code;
+		opReply->port = ntohs(rawOpReply->bindPort);
+		
+		result = Address::parse((SOCKS6AddressType)rawOpReply->addressType, &tmpBB, &opReply->address);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::OP_REPLY, &tmpBB, result);
+		
+		result = opReply->options.parse(&tmpBB, ntohs(rawOpReply->optionsLength));
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::OP_REPLY, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::OP_REPLY, &tmpBB, PR_SUCCESS);
+	}
+	
+	/*
+	 * Works out the size of the message at the start of bb from its first bytes.
+	 * PR_SUCCESS: *size is the size of the whole message.
+	 * PR_BUFFER: *size bytes are needed to tell.
+	 */
+	static ParseResult peekSize(ByteBuffer *bb, size_t *size) noexcept
+	{
+		ByteBuffer tmpBB(*bb);
+		SOCKS6OperationReply *rawOpReply;
+		
+		*size = sizeof(SOCKS6OperationReply);
+		ParseResult result = parseHead(&tmpBB, &rawOpReply);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		size_t addrSize;
+		result = Address::peekSize((SOCKS6AddressType)rawOpReply->addressType, &tmpBB, &addrSize);
+		*size += addrSize;
+		if (result != PR_SUCCESS)
+			return result;
+		
+		uint16_t optionsLength = ntohs(rawOpReply->optionsLength);
+		*size += optionsLength;
+		return OptionSet::checkLength(optionsLength);
+	}
 	
 	void pack(ByteBuffer *bb) const
 	{
+		S6M_PROBE(pack_entry, ParseStats::OP_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		size_t start = bb->getUsed();
 		SOCKS6OperationReply *rawOpReply = bb->get<SOCKS6OperationReply>();
 		
 		rawOpReply->version       = SOCKS6_VERSION;
 		rawOpReply->code          = code;
-		rawOpReply->optionsLength = htons(options.packedSize());
 		rawOpReply->bindPort      = htons(port);
 		rawOpReply->padding       = 0;
 		rawOpReply->addressType   = address.getType();
 		
 		address.pack(bb);
+		size_t optionsStart = bb->getUsed();
 		options.pack(bb);
+		/* known once the options are in */
+		rawOpReply->optionsLength = htons(bb->getUsed() - optionsStart);
+		S6M_PROBE(pack_return, ParseStats::OP_REPLY, bb->getUsed() - start, 0);
+	}
+	
+	/* large fields are referenced, not copied; gb->finish() once done */
+	void pack(GatherBuffer *gb) const
+	{
+		SOCKS6OperationReply *rawOpReply = gb->get<SOCKS6OperationReply>();
+		
+		rawOpReply->version       = SOCKS6_VERSION;
+		rawOpReply->code          = code;
+		rawOpReply->bindPort      = htons(port);
+		rawOpReply->padding       = 0;
+		rawOpReply->addressType   = address.getType();
+		
+		address.pack(gb);
+		size_t optionsStart = gb->getTotalSize();
+		options.pack(gb);
+		/* known once the options are in */
+		rawOpReply->optionsLength = htons(gb->getTotalSize() - optionsStart);
 	}
 	
 	size_t pack(uint8_t *buf, size_t bufSize) const
@@ -49,12 +128,26 @@ struct OperationReply: public MessageBase<SOCKS6_VERSION, SOCKS6OperationReply>
 		return bb.getUsed();
 	}
 	
+	/* appends the message to out */
+	size_t pack(std::vector<uint8_t> *out) const
+	{
+		size_t offset = out->size();
+		out->resize(offset + packedSize());
+		
+		ByteBuffer bb(out->data() + offset, out->size() - offset);
+		pack(&bb);
+		return bb.getUsed();
+	}
+	
 	size_t packedSize() const
 	{
 		return sizeof(SOCKS6OperationReply) + address.packedSize() + options.packedSize();
 	}
 };
 
+/* messages are meant to live on the stack */
+static_assert(sizeof(OperationReply) <= 448, "OperationReply outgrew its size budget");
+
 }
 
 #endif // SOCKS6MSG_OPREPLY_HH
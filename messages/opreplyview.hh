@@ -0,0 +1,61 @@
+#ifndef SOCKS6MSG_OPREPLYVIEW_HH
+#define SOCKS6MSG_OPREPLYVIEW_HH
+
+#include "opreply.hh"
+#include "optionsetview.hh"
+
+namespace S6M
+{
+
+/*
+ * OperationReply that points into the buffer it was parsed from.
+ * The buffer must outlive the view; parsing allocates nothing.
+ */
+struct OperationReplyView: public MessageBase<SOCKS6_VERSION, SOCKS6OperationReply>
+{
+	SOCKS6OperationReplyCode code = SOCKS6_OPERATION_REPLY_SUCCESS;
+	
+	AddressView address;
+	uint16_t    port = 0;
+	
+	OptionSetView options { OptionSetBase::M_OP_REP };
+	
+	/*
+	 * Expects a freshly constructed opReply; its contents are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, OperationReplyView *opReply) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::OP_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		BUFFER tmpBB(*bb);
+		SOCKS6OperationReply *rawOpReply;
+		
+		ParseResult result = parseHead(&tmpBB, &rawOpReply);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::OP_REPLY, &tmpBB, result);
+		
+		opReply->code = (SOCKS6OperationReplyCode)rawOpReply->code;
+		opReply->port = ntohs(rawOpReply->bindPort);
+		
+		result = AddressView::parse((SOCKS6AddressType)rawOpReply->addressType, &tmpBB, &opReply->address);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::OP_REPLY, &tmpBB, result);
+		
+		result = opReply->options.parse(&tmpBB, ntohs(rawOpReply->optionsLength));
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::OP_REPLY, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::OP_REPLY, &tmpBB, PR_SUCCESS);
+	}
+	
+	static ParseResult peekSize(ByteBuffer *bb, size_t *size) noexcept
+	{
+		return OperationReply::peekSize(bb, size);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_OPREPLYVIEW_HH
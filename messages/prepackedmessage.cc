@@ -0,0 +1,55 @@
+#include <stddef.h>
+#include "prepackedmessage.hh"
+
+using namespace std;
+
+namespace S6M
+{
+
+PrepackedMessage::PrepackedMessage(const AuthenticationReply &authReply)
+	: bytes(authReply.packedSize())
+{
+	authReply.pack(bytes.data(), bytes.size());
+	
+	codeOffset = offsetof(SOCKS6AuthReply, type);
+	findOptions(sizeof(SOCKS6AuthReply), authReply.options);
+}
+
+PrepackedMessage::PrepackedMessage(const OperationReply &opReply)
+	: bytes(opReply.packedSize())
+{
+	opReply.pack(bytes.data(), bytes.size());
+	
+	codeOffset    = offsetof(SOCKS6OperationReply, code);
+	portOffset    = offsetof(SOCKS6OperationReply, bindPort);
+	addressType   = opReply.address.getType();
+	/* domains are left alone: their length would have to stay the same */
+	if (addressType != SOCKS6_ADDR_DOMAIN)
+		addressOffset = sizeof(SOCKS6OperationReply);
+	findOptions(sizeof(SOCKS6OperationReply) + opReply.address.packedSize(), opReply.options);
+}
+
+void PrepackedMessage::findOptions(size_t offset, const OptionSet &options)
+{
+	/* walks what was just packed, so the options are known to be well-formed */
+	while (offset + sizeof(SOCKS6Option) <= bytes.size())
+	{
+		SOCKS6Option *opt = reinterpret_cast<SOCKS6Option *>(bytes.data() + offset);
+		
+		switch (ntohs(opt->kind))
+		{
+		case SOCKS6_OPTION_IDEMPOTENCE_WND:
+			windowOffset = offset + offsetof(SOCKS6WindowAdvertOption, windowBase);
+			break;
+			
+		case SOCKS6_OPTION_SESSION_ID:
+			sessionIDOffset = offset + sizeof(SOCKS6SessionIDOption);
+			sessionIDSize   = options.session.getID()->size();
+			break;
+		}
+		
+		offset += ntohs(opt->len);
+	}
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef SOCKS6MSG_PREPACKEDMESSAGE_HH
+#define SOCKS6MSG_PREPACKEDMESSAGE_HH
+
+#include <vector>
+#include "authreply.hh"
+#include "opreply.hh"
+
+namespace S6M
+{
+
+/*
+ * A reply packed once, for servers that send many replies of the same shape.
+ * The offsets of the fields that vary between sends are noted at construction;
+ * the setters patch them in place, and pack() is then a plain copy.
+ * Patches can't change the size of the message: addresses keep their type and session IDs their length.
+ * Patching changes the template itself, so each thread needs its own copy.
+ */
+class PrepackedMessage
+{
+	std::vector<uint8_t> bytes;
+	
+	/* 0 where the template has no such field */
+	size_t codeOffset      = 0;
+	size_t portOffset      = 0;
+	size_t addressOffset   = 0;
+	size_t windowOffset    = 0;
+	size_t sessionIDOffset = 0;
+	
+	SOCKS6AddressType addressType = SOCKS6_ADDR_IPV4;
+	size_t sessionIDSize = 0;
+	
+	void findOptions(size_t offset, const OptionSet &options);
+	
+	void patch(size_t offset, const void *value, size_t size)
+	{
+		if (offset == 0)
+			throw std::logic_error("Field not in template");
+		memcpy(bytes.data() + offset, value, size);
+	}
+	
+public:
+	explicit PrepackedMessage(const AuthenticationReply &authReply);
+	
+	explicit PrepackedMessage(const OperationReply &opReply);
+	
+	/* SOCKS6AuthReplyCode or SOCKS6OperationReplyCode, depending on the message */
+	void setCode(uint8_t code)
+	{
+		patch(codeOffset, &code, sizeof(code));
+	}
+	
+	void setPort(uint16_t port)
+	{
+		uint16_t rawPort = htons(port);
+		patch(portOffset, &rawPort, sizeof(rawPort));
+	}
+	
+	void setAddress(in_addr ipv4)
+	{
+		if (addressType != SOCKS6_ADDR_IPV4)
+			throw BadAddressTypeException();
+		patch(addressOffset, &ipv4, sizeof(ipv4));
+	}
+	
+	void setAddress(in6_addr ipv6)
+	{
+		if (addressType != SOCKS6_ADDR_IPV6)
+			throw BadAddressTypeException();
+		patch(addressOffset, &ipv6, sizeof(ipv6));
+	}
+	
+	void setWindow(std::pair<uint32_t, uint32_t> window)
+	{
+		uint32_t rawWindow[2] = { htonl(window.first), htonl(window.second) };
+		patch(windowOffset, rawWindow, sizeof(rawWindow));
+	}
+	
+	void setSessionID(const uint8_t *id, size_t size)
+	{
+		if (size != sessionIDSize)
+			throw std::invalid_argument("Bad session ID size");
+		patch(sessionIDOffset, id, size);
+	}
+	
+	void setSessionID(const SessionID &id)
+	{
+		setSessionID(id.data(), id.size());
+	}
+	
+	void pack(ByteBuffer *bb) const
+	{
+		bb->put(bytes.data(), bytes.size());
+	}
+	
+	size_t pack(uint8_t *buf, size_t bufSize) const
+	{
+		ByteBuffer bb(buf, bufSize);
+		pack(&bb);
+		return bb.getUsed();
+	}
+	
+	size_t packedSize() const
+	{
+		return bytes.size();
+	}
+	
+	const uint8_t *getBytes() const
+	{
+		return bytes.data();
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_PREPACKEDMESSAGE_HH
@@ -15,31 +15,110 @@ struct Request: public MessageBase<SOCKS6_VERSION, SOCKS6Request>
 	Address  address;
 	uint16_t port;
 	
-	OptionSet options { OptionSet::M_REQ };
+	OptionSet options;
 	
-	Request(SOCKS6RequestCode commandCode, Address address = Address(), uint16_t port = 0)
-		: code(commandCode), address(address), port(port) {}
+	/* the domain and variable-length options are allocated from resource */
+	Request(SOCKS6RequestCode commandCode, const Address &address = Address(), uint16_t port = 0, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: code(commandCode), address(address, resource), port(port), options(OptionSet::M_REQ, resource) {}
 	
-	Request(ByteBuffer *bb)
-		: MessageBase(bb),
-		  code((SOCKS6RequestCode)rawMessage->commandCode),
-		  address((SOCKS6AddressType)rawMessage->addressType, bb),
-		  port(ntohs(rawMessage->port)),
-		  options(bb, OptionSet::M_REQ, ntohs(rawMessage->optionsLength)) {}
+	Request(ByteBuffer *bb, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: Request(SOCKS6_REQUEST_NOOP, Address(), 0, resource)
+	{
+		enforceParseResult(parse(bb, this), bb);
+	}
+	
+	/*
+	 * Expects a freshly constructed req; its contents are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, Request *req) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::REQUEST, bb->getTotalSize() - bb->getUsed(), 0);
+		BUFFER tmpBB(*bb);
+		SOCKS6Request *rawRequest;
+		
+		ParseResult result = parseHead(&tmpBB, &rawRequest);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::REQUEST, &tmpBB, result);
+		
+		req->code = (SOCKS6RequestCode)rawRequest->commandCode;
+		req->port = ntohs(rawRequest->port);
+		
+		result = Address::parse((SOCKS6AddressType)rawRequest->addressType, &tmpBB, &req->address);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::REQUEST, &tmpBB, result);
+		
+		result = req->options.parse(&tmpBB, ntohs(rawRequest->optionsLength));
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::REQUEST, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::REQUEST, &tmpBB, PR_SUCCESS);
+	}
+	
+	/*
+	 * Works out the size of the message at the start of bb from its first bytes.
+	 * PR_SUCCESS: *size is the size of the whole message.
+	 * PR_BUFFER: *size bytes are needed to tell.
+	 */
+	static ParseResult peekSize(ByteBuffer *bb, size_t *size) noexcept
+	{
+		ByteBuffer tmpBB(*bb);
+		SOCKS6Request *rawRequest;
+		
+		*size = sizeof(SOCKS6Request);
+		ParseResult result = parseHead(&tmpBB, &rawRequest);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		size_t addrSize;
+		result = Address::peekSize((SOCKS6AddressType)rawRequest->addressType, &tmpBB, &addrSize);
+		*size += addrSize;
+		if (result != PR_SUCCESS)
+			return result;
+		
+		uint16_t optionsLength = ntohs(rawRequest->optionsLength);
+		*size += optionsLength;
+		return OptionSet::checkLength(optionsLength);
+	}
 	
 	void pack(ByteBuffer *bb) const
 	{
+		S6M_PROBE(pack_entry, ParseStats::REQUEST, bb->getTotalSize() - bb->getUsed(), 0);
+		size_t start = bb->getUsed();
 		SOCKS6Request *rawRequest = bb->get<SOCKS6Request>();
 		
 		rawRequest->version       = SOCKS6_VERSION;
 		rawRequest->commandCode   = code;
-		rawRequest->optionsLength = htons(options.packedSize());
 		rawRequest->port          = htons(port);
 		rawRequest->padding       = 0;
 		rawRequest->addressType   = address.getType();
 		
 		address.pack(bb);
+		size_t optionsStart = bb->getUsed();
 		options.pack(bb);
+		/* known once the options are in */
+		rawRequest->optionsLength = htons(bb->getUsed() - optionsStart);
+		S6M_PROBE(pack_return, ParseStats::REQUEST, bb->getUsed() - start, 0);
+	}
+	
+	/* large fields are referenced, not copied; gb->finish() once done */
+	void pack(GatherBuffer *gb) const
+	{
+		SOCKS6Request *rawRequest = gb->get<SOCKS6Request>();
+		
+		rawRequest->version       = SOCKS6_VERSION;
+		rawRequest->commandCode   = code;
+		rawRequest->port          = htons(port);
+		rawRequest->padding       = 0;
+		rawRequest->addressType   = address.getType();
+		
+		address.pack(gb);
+		size_t optionsStart = gb->getTotalSize();
+		options.pack(gb);
+		/* known once the options are in */
+		rawRequest->optionsLength = htons(gb->getTotalSize() - optionsStart);
 	}
 	
 	size_t pack(uint8_t *buf, size_t bufSize) const
@@ -49,12 +128,26 @@ struct Request: public MessageBase<SOCKS6_VERSION, SOCKS6Request>
 		return bb.getUsed();
 	}
 	
+	/* appends the message to out */
+	size_t pack(std::vector<uint8_t> *out) const
+	{
+		size_t offset = out->size();
+		out->resize(offset + packedSize());
+		
+		ByteBuffer bb(out->data() + offset, out->size() - offset);
+		pack(&bb);
+		return bb.getUsed();
+	}
+	
 	size_t packedSize() const
 	{
 		return sizeof(SOCKS6Request) + address.packedSize() + options.packedSize();
 	}
 };
 
+/* messages are meant to live on the stack */
+static_assert(sizeof(Request) <= 448, "Request outgrew its size budget");
+
 }
 
 #endif // SOCKS6MSG_REQUEST_HH
@@ -0,0 +1,61 @@
+#ifndef SOCKS6MSG_REQUESTVIEW_HH
+#define SOCKS6MSG_REQUESTVIEW_HH
+
+#include "request.hh"
+#include "optionsetview.hh"
+
+namespace S6M
+{
+
+/*
+ * Request that points into the buffer it was parsed from.
+ * The buffer must outlive the view; parsing allocates nothing.
+ */
+struct RequestView: public MessageBase<SOCKS6_VERSION, SOCKS6Request>
+{
+	SOCKS6RequestCode code = SOCKS6_REQUEST_NOOP;
+	
+	AddressView address;
+	uint16_t    port = 0;
+	
+	OptionSetView options { OptionSetBase::M_REQ };
+	
+	/*
+	 * Expects a freshly constructed req; its contents are unspecified on failure.
+	 * bb is only advanced on success.
+	 */
+	template <typename BUFFER>
+	static ParseResult parse(BUFFER *bb, RequestView *req) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::REQUEST, bb->getTotalSize() - bb->getUsed(), 0);
+		BUFFER tmpBB(*bb);
+		SOCKS6Request *rawRequest;
+		
+		ParseResult result = parseHead(&tmpBB, &rawRequest);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::REQUEST, &tmpBB, result);
+		
+		req->code = (SOCKS6RequestCode)rawRequest->commandCode;
+		req->port = ntohs(rawRequest->port);
+		
+		result = AddressView::parse((SOCKS6AddressType)rawRequest->addressType, &tmpBB, &req->address);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::REQUEST, &tmpBB, result);
+		
+		result = req->options.parse(&tmpBB, ntohs(rawRequest->optionsLength));
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::REQUEST, &tmpBB, result);
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::REQUEST, &tmpBB, PR_SUCCESS);
+	}
+	
+	static ParseResult peekSize(ByteBuffer *bb, size_t *size) noexcept
+	{
+		return Request::peekSize(bb, size);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_REQUESTVIEW_HH
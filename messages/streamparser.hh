@@ -0,0 +1,137 @@
+#ifndef SOCKS6MSG_STREAMPARSER_HH
+#define SOCKS6MSG_STREAMPARSER_HH
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "bytebuffer.hh"
+#include "parseresult.hh"
+
+namespace S6M
+{
+
+/**
+ * @brief Resumable parser for messages that arrive in pieces
+ * MSG is Request, AuthenticationReply or OperationReply.
+ * Bytes are accumulated until the whole message is in; the message is then parsed once.
+ * Bytes past the end of the message are never consumed.
+ *
+ * Reading straight from a socket:
+ *     ssize_t n = recv(fd, parser.tail(), parser.missing(), 0);
+ *     if (parser.commit(n) == PR_SUCCESS && parser.missing() == 0)
+ *         parser.parse(&req);
+ */
+template <typename MSG>
+class StreamParser
+{
+	std::vector<uint8_t> buf;
+
+	size_t received;
+	size_t required;
+	bool   sizeKnown;
+
+	ParseResult update()
+	{
+		while (!sizeKnown && received >= required)
+		{
+			ByteBuffer bb(buf.data(), received);
+
+			ParseResult result = MSG::peekSize(&bb, &required);
+			if (result == PR_SUCCESS)
+				sizeKnown = true;
+			else if (result != PR_BUFFER)
+				return result;
+		}
+		return PR_SUCCESS;
+	}
+
+public:
+	StreamParser()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		received  = 0;
+		required  = 1;
+		sizeKnown = false;
+	}
+
+	/* exact once the message size is known */
+	size_t missing() const
+	{
+		return required - received;
+	}
+
+	bool sizeIsKnown() const
+	{
+		return sizeKnown;
+	}
+
+	size_t getReceived() const
+	{
+		return received;
+	}
+
+	/* room for missing() bytes; follow up with commit() */
+	uint8_t *tail()
+	{
+		if (buf.size() < required)
+			buf.resize(required);
+		return buf.data() + received;
+	}
+
+	/*
+	 * Accounts for count bytes written to tail().
+	 * Fails early if the fixed part of the message is bad.
+	 */
+	ParseResult commit(size_t count)
+	{
+		received += count;
+		return update();
+	}
+
+	/* Takes as many bytes from bb as the message needs. */
+	ParseResult feed(ByteBuffer *bb)
+	{
+		while (missing() > 0)
+		{
+			size_t avail = bb->getTotalSize() - bb->getUsed();
+			if (avail == 0)
+				break;
+
+			size_t count = std::min(avail, missing());
+			memcpy(tail(), bb->tryGet<uint8_t>(count), count);
+
+			ParseResult result = commit(count);
+			if (result != PR_SUCCESS)
+				return result;
+		}
+		return PR_SUCCESS;
+	}
+
+	/*
+	 * PR_BUFFER: missing() more bytes are needed.
+	 * PR_SUCCESS: msg holds the message; the parser is ready for the next one.
+	 * msg must be freshly constructed.
+	 */
+	ParseResult parse(MSG *msg)
+	{
+		ParseResult result = update();
+		if (result != PR_SUCCESS)
+			return result;
+		if (!sizeKnown || received < required)
+			return PR_BUFFER;
+
+		ByteBuffer bb(buf.data(), received);
+		result = MSG::parse(&bb, msg);
+		if (result == PR_SUCCESS)
+			reset();
+		return result;
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_STREAMPARSER_HH
@@ -19,6 +19,44 @@ public:
 	UserPasswordRequest(ByteBuffer *bb)
 		: MessageBase(bb), username(bb), password(bb) {}
 	
+	/* views point into bb */
+	static ParseResult parseCredentials(ByteBuffer *bb, std::pair<std::string_view, std::string_view> *creds) noexcept
+	{
+		uint8_t *rawVer;
+		ParseResult result = parseHead(bb, &rawVer);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		result = String::parse(bb, &creds->first);
+		if (result != PR_SUCCESS)
+			return result;
+		
+		return String::parse(bb, &creds->second);
+	}
+	
+	static ParseResult parse(ByteBuffer *bb, UserPasswordRequest *req) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::PASSWD_REQ, bb->getTotalSize() - bb->getUsed(), 0);
+		ByteBuffer tmpBB(*bb);
+		std::pair<std::string_view, std::string_view> creds;
+		
+		ParseResult result = parseCredentials(&tmpBB, &creds);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::PASSWD_REQ, &tmpBB, result);
+		
+		try
+		{
+			*req = UserPasswordRequest(creds);
+		}
+		catch (std::bad_alloc &)
+		{
+			return parseExit(ParseStats::PASSWD_REQ, &tmpBB, PR_ALLOC);
+		}
+		
+		*bb = tmpBB;
+		return parseExit(ParseStats::PASSWD_REQ, &tmpBB, PR_SUCCESS);
+	}
+	
 	std::pair<std::string_view, std::string_view> getCredentials() const
 	{
 		return { username.getStr(), password.getStr() };
@@ -62,6 +100,25 @@ struct UserPasswordReply: public MessageBase<SOCKS6_USERPASSWD_VERSION, uint8_t>
 		success = *status == 0x00;
 	}
 	
+	static ParseResult parse(ByteBuffer *bb, UserPasswordReply *rep) noexcept
+	{
+		S6M_PROBE(parse_entry, ParseStats::PASSWD_REPLY, bb->getTotalSize() - bb->getUsed(), 0);
+		ByteBuffer tmpBB(*bb);
+		uint8_t *rawVer;
+		
+		ParseResult result = parseHead(&tmpBB, &rawVer);
+		if (result != PR_SUCCESS)
+			return parseExit(ParseStats::PASSWD_REPLY, &tmpBB, result);
+		
+		uint8_t *status = tmpBB.tryGet<uint8_t>();
+		if (!status)
+			return parseExit(ParseStats::PASSWD_REPLY, &tmpBB, PR_BUFFER);
+		
+		rep->success = *status == 0x00;
+		*bb = tmpBB;
+		return parseExit(ParseStats::PASSWD_REPLY, &tmpBB, PR_SUCCESS);
+	}
+	
 	void pack(ByteBuffer *bb) const
 	{
 		uint8_t *ver = bb->get<uint8_t>();
@@ -1,5 +1,6 @@
 #include "authdataoption.hh"
 #include "optionset.hh"
+#include "optionsetview.hh"
 #include "exceptions.hh"
 
 using namespace std;
@@ -16,28 +17,37 @@ void AuthDataOption::fill(uint8_t *buf) const
 	opt->method = method;
 }
 
-void AuthDataOption::incrementalParse(SOCKS6Option *baseOpt, OptionSet *optionSet)
+template <typename SET>
+ParseResult AuthDataOption::incrementalParse(SOCKS6Option *baseOpt, SET *optionSet)
 {
-	SOCKS6AuthDataOption *opt = rawOptCast<SOCKS6AuthDataOption>(baseOpt);
+	SOCKS6AuthDataOption *opt = reinterpret_cast<SOCKS6AuthDataOption *>(baseOpt);
 	
 	switch (opt->method)
 	{
 	case SOCKS6_METHOD_NOAUTH:
 	case SOCKS6_METHOD_UNACCEPTABLE:
-		throw invalid_argument("Bad method");
+		/* bad method */
+		return PR_INVALID;
 		
 	case SOCKS6_METHOD_USRPASSWD:
 		if (optionSet->getMode() == OptionSet::M_REQ)
-			UsernamePasswdReqOption::incrementalParse(opt, optionSet);
+			return UsernamePasswdReqOption::incrementalParse(opt, optionSet);
 		else
-			UsernamePasswdReplyOption::incrementalParse(opt, optionSet);
-		break;
+			return UsernamePasswdReplyOption::incrementalParse(opt, optionSet);
 		
 	default:
-		throw invalid_argument("Unsupported method");
+		/* unsupported method */
+		return PR_INVALID;
 	}	
 }
 
+size_t UsernamePasswdReqOption::sizeOf(const std::pair<std::string_view, std::string_view> &creds)
+{
+	/* version, then length-prefixed username and password */
+	size_t reqSize = 1 + 1 + creds.first.length() + 1 + creds.second.length();
+	return sizeof(SOCKS6AuthDataOption) + reqSize + paddingOf(sizeof(SOCKS6AuthDataOption) + reqSize);
+}
+
 size_t UsernamePasswdReqOption::packedSize() const
 {
 	return sizeof(SOCKS6AuthDataOption) + req.packedSize();
@@ -54,30 +64,27 @@ void UsernamePasswdReqOption::fill(uint8_t *buf) const
 	req.pack(&bb);
 }
 
-void UsernamePasswdReqOption::incrementalParse(SOCKS6AuthDataOption *baseOpt, OptionSet *optionSet)
+template <typename SET>
+ParseResult UsernamePasswdReqOption::incrementalParse(SOCKS6AuthDataOption *baseOpt, SET *optionSet)
 {
 	SOCKS6AuthDataOption *opt = (SOCKS6AuthDataOption *)baseOpt;
 	
 	size_t expectedDataSize = ntoh(opt->optionHead.len) - sizeof(SOCKS6AuthDataOption);
 	
-	try
-	{
-		ByteBuffer bb(opt->methodData, expectedDataSize);
-		PaddedRequest req(&bb);
-		
-		if (bb.getUsed() != expectedDataSize)
-			throw invalid_argument("Spurious bytes at the end of the option");
-		
-		optionSet->userPassword.setCredentials(req.getCredentials());
-	}
-	catch (length_error &)
-	{
-		throw invalid_argument("Truncated payload");
-	}
-	catch (BadVersionException &)
-	{
-		throw invalid_argument("Unsupported version");
-	}
+	ByteBuffer bb(opt->methodData, expectedDataSize);
+	pair<string_view, string_view> creds;
+	
+	/* truncated payload or unsupported version */
+	if (UserPasswordRequest::parseCredentials(&bb, &creds) != PR_SUCCESS)
+		return PR_INVALID;
+	if (!bb.tryGet<uint8_t>(paddingOf(bb.getUsed() + sizeof(SOCKS6AuthDataOption))))
+		return PR_INVALID;
+	
+	/* spurious bytes at the end of the option */
+	if (bb.getUsed() != expectedDataSize)
+		return PR_INVALID;
+	
+	return optionSet->userPassword.trySetCredentials(creds) ? PR_SUCCESS : PR_INVALID;
 }
 
 UsernamePasswdReqOption::UsernamePasswdReqOption(const std::pair<string_view, string_view> &creds)
@@ -105,20 +112,31 @@ void UsernamePasswdReplyOption::fill(uint8_t *buf) const
 }
 
 size_t UsernamePasswdReplyOption::packedSize() const
+{
+	return sizeOf();
+}
+
+size_t UsernamePasswdReplyOption::sizeOf()
 {
 	return sizeof(RawUsrPasswdReply);
 }
 
-void UsernamePasswdReplyOption::incrementalParse(SOCKS6AuthDataOption *baseOpt, OptionSet *optionSet)
+template <typename SET>
+ParseResult UsernamePasswdReplyOption::incrementalParse(SOCKS6AuthDataOption *baseOpt, SET *optionSet)
 {
 	RawUsrPasswdReply *opt = rawOptCast<RawUsrPasswdReply>(baseOpt, false);
+	if (!opt)
+		return PR_INVALID;
 	
 	if (opt->version != SOCKS6_PWAUTH_VERSION)
-		throw BadVersionException(opt->version);
+		return PR_INVALID;
 	
 	bool success = !opt->status;
 	
-	optionSet->userPassword.setReply(success);
+	return optionSet->userPassword.trySetReply(success) ? PR_SUCCESS : PR_INVALID;
 }
 
+template ParseResult AuthDataOption::incrementalParse(SOCKS6Option *baseOpt, OptionSet *optionSet);
+template ParseResult AuthDataOption::incrementalParse(SOCKS6Option *baseOpt, OptionSetView *optionSet);
+
 }
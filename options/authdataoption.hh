@@ -15,12 +15,18 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_AUTH_DATA;
+	static constexpr bool             PAYLOAD = true;
+	
+	typedef SOCKS6AuthDataOption RawOption;
+	
 	SOCKS6Method getMethod() const
 	{
 		return method;
 	}
 	
-	static void incrementalParse(SOCKS6Option *baseOpt, OptionSet *optionSet);
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *baseOpt, SET *optionSet);
 	
 	AuthDataOption(SOCKS6Method method)
 		: Option(SOCKS6_OPTION_AUTH_DATA), method(method) {}
@@ -38,7 +44,10 @@ protected:
 public:
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6AuthDataOption *baseOpt, OptionSet *optionSet);
+	static size_t sizeOf(const std::pair<std::string_view, std::string_view> &creds);
+	
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6AuthDataOption *baseOpt, SET *optionSet);
 	
 	UsernamePasswdReqOption(const std::pair<std::string_view, std::string_view> &creds);
 	
@@ -58,7 +67,10 @@ protected:
 public:
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6AuthDataOption *baseOpt, OptionSet *optionSet);
+	static size_t sizeOf();
+	
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6AuthDataOption *baseOpt, SET *optionSet);
 	
 	UsernamePasswdReplyOption(bool success)
 		: AuthDataOption(SOCKS6_METHOD_USRPASSWD), success(success) {}
@@ -1,6 +1,7 @@
 #include <arpa/inet.h>
 #include "authmethodoption.hh"
 #include "optionset.hh"
+#include "optionsetview.hh"
 #include "padded.hh"
 
 using namespace std;
@@ -8,9 +9,15 @@ using namespace std;
 namespace S6M
 {
 
+size_t AuthMethodAdvertOption::sizeOf(size_t methodCount)
+{
+	size_t unpadded = sizeof(SOCKS6AuthMethodAdvertOption) + methodCount * sizeof(uint8_t);
+	return unpadded + paddingOf(unpadded);
+}
+
 size_t AuthMethodAdvertOption::packedSize() const
 {
-	return unpaddedSize() + paddingOf(unpaddedSize());
+	return sizeOf(methods.size());
 }
 
 void AuthMethodAdvertOption::fill(uint8_t *buf) const
@@ -25,32 +32,42 @@ void AuthMethodAdvertOption::fill(uint8_t *buf) const
 	for (SOCKS6Method method: methods)
 		opt->methods[i++] = method;
 	
-	for (int j = 0; j < (int)paddingOf(unpaddedSize()); j++)
-		opt->methods[i + j] = 0;
+	for (; i < (int)(packedSize() - sizeof(SOCKS6AuthMethodAdvertOption)); i++)
+		opt->methods[i] = 0;
 }
 
-void AuthMethodAdvertOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet)
+template <typename SET>
+ParseResult AuthMethodAdvertOption::incrementalParse(SOCKS6Option *optBase, SET *optionSet)
 {
-	SOCKS6AuthMethodAdvertOption *opt = rawOptCast<SOCKS6AuthMethodAdvertOption>(optBase);
+	SOCKS6AuthMethodAdvertOption *opt = reinterpret_cast<SOCKS6AuthMethodAdvertOption *>(optBase);
 
 	uint16_t initDataLen = ntoh(opt->initialDataLen);
 	
 	int methodCount = ntoh(opt->optionHead.len) - sizeof(SOCKS6AuthMethodAdvertOption);
+	Span<const uint8_t> methods(opt->methods, methodCount);
 	
-	set<SOCKS6Method> methods;
-	for (int i = 0; i < methodCount; i++)
-		methods.insert((SOCKS6Method)opt->methods[i]);
+	bool acceptable = false;
+	for (uint8_t method: methods)
+	{
+		if (method == SOCKS6_METHOD_UNACCEPTABLE)
+			return PR_INVALID;
+		if (method != SOCKS6_METHOD_NOAUTH)
+			acceptable = true;
+	}
+	if (!acceptable)
+		return PR_INVALID;
 	
-	optionSet->authMethods.advertise(methods, initDataLen);
+	return optionSet->authMethods.tryAdvertise(methods, initDataLen) ? PR_SUCCESS : PR_INVALID;
 }
 
-AuthMethodAdvertOption::AuthMethodAdvertOption(uint16_t initialDataLen, std::set<SOCKS6Method> methods)
+AuthMethodAdvertOption::AuthMethodAdvertOption(uint16_t initialDataLen, AuthMethodMask methods)
 	: Option(SOCKS6_OPTION_AUTH_METHOD_ADVERT), initialDataLen(initialDataLen), methods(methods)
 {
-	if (methods.find(SOCKS6_METHOD_UNACCEPTABLE) != methods.end())
+	if (this->methods.contains(SOCKS6_METHOD_UNACCEPTABLE))
 		throw invalid_argument("Bad method");
-	methods.erase(SOCKS6_METHOD_NOAUTH);
-	if (methods.empty())
+	/* implied */
+	this->methods.erase(SOCKS6_METHOD_NOAUTH);
+	if (this->methods.empty())
 		throw invalid_argument("No methods");
 }
 
@@ -69,18 +86,27 @@ size_t AuthMethodSelectOption::packedSize() const
 	return sizeof(SOCKS6AuthMethodSelectOption);
 }
 
-void AuthMethodSelectOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet)
+template <typename SET>
+ParseResult AuthMethodSelectOption::incrementalParse(SOCKS6Option *optBase, SET *optionSet)
 {
-	SOCKS6AuthMethodSelectOption *opt = rawOptCast<SOCKS6AuthMethodSelectOption>(optBase, false);
+	SOCKS6AuthMethodSelectOption *opt = reinterpret_cast<SOCKS6AuthMethodSelectOption *>(optBase);
 	
-	optionSet->authMethods.select((SOCKS6Method)opt->method);
+	if (opt->method == SOCKS6_METHOD_NOAUTH)
+		return PR_INVALID;
+	
+	return optionSet->authMethods.trySelect((SOCKS6Method)opt->method) ? PR_SUCCESS : PR_INVALID;
 }
 
 AuthMethodSelectOption::AuthMethodSelectOption(SOCKS6Method method)
-	: Option(SOCKS6_OPTION_AUTH_METHOD_ADVERT), method(method)
+	: Option(SOCKS6_OPTION_AUTH_METHOD_SELECT), method(method)
 {
 	if (method == SOCKS6_METHOD_NOAUTH)
 		throw logic_error("Bad method");
 }
 
+template ParseResult AuthMethodAdvertOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+template ParseResult AuthMethodSelectOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+template ParseResult AuthMethodAdvertOption::incrementalParse(SOCKS6Option *optBase, OptionSetView *optionSet);
+template ParseResult AuthMethodSelectOption::incrementalParse(SOCKS6Option *optBase, OptionSetView *optionSet);
+
 }
@@ -2,36 +2,40 @@
 #define SOCKS6MSG_AUTHMETHODOPTION_HH
 
 #include "option.hh"
+#include "authmethodmask.hh"
 
 namespace S6M
 {
 
 class AuthMethodAdvertOption: public Option
 {
-	uint16_t               initialDataLen;
-	std::set<SOCKS6Method> methods;
+	uint16_t       initialDataLen;
+	AuthMethodMask methods;
 	
 protected:
 	virtual void fill(uint8_t *buf) const;
 	
-	size_t unpaddedSize() const
-	{
-		return sizeof(SOCKS6Option) + methods.size() * sizeof(uint8_t);
-	}
-	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_AUTH_METHOD_ADVERT;
+	static constexpr bool             PAYLOAD = true;
+	
+	typedef SOCKS6AuthMethodAdvertOption RawOption;
+	
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+	static size_t sizeOf(size_t methodCount);
+	
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *optBase, SET *optionSet);
 	
-	AuthMethodAdvertOption(uint16_t initialDataLen, std::set<SOCKS6Method> methods);
+	AuthMethodAdvertOption(uint16_t initialDataLen, AuthMethodMask methods);
 
 	uint16_t getInitialDataLen() const
 	{
 		return initialDataLen;
 	}
 
-	const std::set<SOCKS6Method> *getMethods() const
+	const AuthMethodMask *getMethods() const
 	{
 		return &methods;
 	}
@@ -45,9 +49,15 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_AUTH_METHOD_SELECT;
+	static constexpr bool             PAYLOAD = false;
+	
+	typedef SOCKS6AuthMethodSelectOption RawOption;
+	
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *optBase, SET *optionSet);
 	
 	AuthMethodSelectOption(SOCKS6Method method);
 
@@ -1,6 +1,7 @@
 #include <arpa/inet.h>
 #include "idempotenceoption.hh"
 #include "optionset.hh"
+#include "optionsetview.hh"
 #include "sanity.hh"
 
 using namespace std;
@@ -22,13 +23,16 @@ size_t IdempotenceRequestOption::packedSize() const
 	return sizeof(SOCKS6WindowRequestOption);
 }
 
-void IdempotenceRequestOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet)
+template <typename SET>
+ParseResult IdempotenceRequestOption::incrementalParse(SOCKS6Option *optBase, SET *optionSet)
 {
-	SOCKS6WindowRequestOption *opt = rawOptCast<SOCKS6WindowRequestOption>(optBase, false);
+	SOCKS6WindowRequestOption *opt = reinterpret_cast<SOCKS6WindowRequestOption *>(optBase);
 	
 	uint32_t winSize = ntohl(opt->windowSize);
+	if (!WindowSize::inBounds(winSize))
+		return PR_INVALID;
 	
-	optionSet->idempotence.request(winSize);
+	return optionSet->idempotence.tryRequest(winSize) ? PR_SUCCESS : PR_INVALID;
 }
 
 size_t IdempotenceWindowOption::packedSize() const
@@ -46,14 +50,17 @@ void IdempotenceWindowOption::fill(uint8_t *buf) const
 	opt->windowSize = htonl(winSize);
 }
 
-void IdempotenceWindowOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet)
+template <typename SET>
+ParseResult IdempotenceWindowOption::incrementalParse(SOCKS6Option *optBase, SET *optionSet)
 {
-	SOCKS6WindowAdvertOption *opt = rawOptCast<SOCKS6WindowAdvertOption>(optBase, false);
+	SOCKS6WindowAdvertOption *opt = reinterpret_cast<SOCKS6WindowAdvertOption *>(optBase);
 	
 	uint32_t winBase = ntohl(opt->windowBase);
 	uint32_t winSize = ntohl(opt->windowSize);
+	if (!WindowSize::inBounds(winSize))
+		return PR_INVALID;
 	
-	optionSet->idempotence.advertise({ winBase, winSize });
+	return optionSet->idempotence.tryAdvertise({ winBase, winSize }) ? PR_SUCCESS : PR_INVALID;
 }
 
 size_t IdempotenceExpenditureOption::packedSize() const
@@ -70,21 +77,35 @@ void IdempotenceExpenditureOption::fill(uint8_t *buf) const
 	opt->token = htonl(token);
 }
 
-void IdempotenceExpenditureOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet)
+template <typename SET>
+ParseResult IdempotenceExpenditureOption::incrementalParse(SOCKS6Option *optBase, SET *optionSet)
 {
-	SOCKS6TokenExpenditureOption *opt = rawOptCast<SOCKS6TokenExpenditureOption>(optBase, false);
+	SOCKS6TokenExpenditureOption *opt = reinterpret_cast<SOCKS6TokenExpenditureOption *>(optBase);
 	
-	optionSet->idempotence.setToken(ntohl(opt->token));
+	return optionSet->idempotence.trySetToken(ntohl(opt->token)) ? PR_SUCCESS : PR_INVALID;
 }
 
-void IdempotenceAcceptedOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool IdempotenceAcceptedOption::simpleParse(SET *optionSet)
 {
-	optionSet->idempotence.setReply(true);
+	return optionSet->idempotence.trySetReply(true);
 }
 
-void IdempotenceRejectedOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool IdempotenceRejectedOption::simpleParse(SET *optionSet)
 {
-	optionSet->idempotence.setReply(false);
+	return optionSet->idempotence.trySetReply(false);
 }
 
+template ParseResult IdempotenceRequestOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+template ParseResult IdempotenceWindowOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+template ParseResult IdempotenceExpenditureOption::incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+template bool IdempotenceAcceptedOption::simpleParse(OptionSet *optionSet);
+template bool IdempotenceRejectedOption::simpleParse(OptionSet *optionSet);
+template ParseResult IdempotenceRequestOption::incrementalParse(SOCKS6Option *optBase, OptionSetView *optionSet);
+template ParseResult IdempotenceWindowOption::incrementalParse(SOCKS6Option *optBase, OptionSetView *optionSet);
+template ParseResult IdempotenceExpenditureOption::incrementalParse(SOCKS6Option *optBase, OptionSetView *optionSet);
+template bool IdempotenceAcceptedOption::simpleParse(OptionSetView *optionSet);
+template bool IdempotenceRejectedOption::simpleParse(OptionSetView *optionSet);
+
 }
@@ -17,9 +17,15 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_IDEMPOTENCE_REQ;
+	static constexpr bool             PAYLOAD = false;
+	
+	typedef SOCKS6WindowRequestOption RawOption;
+	
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *optBase, SET *optionSet);
 	
 	IdempotenceRequestOption(uint32_t winSize)
 		: Option(SOCKS6_OPTION_IDEMPOTENCE_REQ), winSize(winSize) {}
@@ -39,9 +45,15 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_IDEMPOTENCE_WND;
+	static constexpr bool             PAYLOAD = false;
+	
+	typedef SOCKS6WindowAdvertOption RawOption;
+	
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *optBase, SET *optionSet);
 	
 	IdempotenceWindowOption(std::pair<uint32_t, uint32_t> window)
 		: Option(SOCKS6_OPTION_IDEMPOTENCE_WND), winBase(window.first), winSize(window.second) {}
@@ -60,9 +72,15 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_IDEMPOTENCE_EXPEND;
+	static constexpr bool             PAYLOAD = false;
+	
+	typedef SOCKS6TokenExpenditureOption RawOption;
+	
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet);
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *optBase, SET *optionSet);
 	
 	IdempotenceExpenditureOption(uint32_t token)
 		: Option(SOCKS6_OPTION_IDEMPOTENCE_EXPEND), token(token) {}
@@ -76,13 +94,15 @@ public:
 class IdempotenceAcceptedOption: public SimpleOptionBase<IdempotenceAcceptedOption, SOCKS6_OPTION_IDEMPOTENCE_ACCEPT>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 class IdempotenceRejectedOption: public SimpleOptionBase<IdempotenceRejectedOption, SOCKS6_OPTION_IDEMPOTENCE_REJECT>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 }
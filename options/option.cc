@@ -6,7 +6,10 @@
 #include "authmethodoption.hh"
 #include "authdataoption.hh"
 #include "optionset.hh"
+#include "optionsetview.hh"
+#include "vendoroption.hh"
 #include "sanity.hh"
+#include "tracepoints.hh"
 
 using namespace std;
 
@@ -18,71 +21,77 @@ void Option::fill(uint8_t *buf) const
 	SOCKS6Option *opt = reinterpret_cast<SOCKS6Option *>(buf);
 	
 	opt->kind = htons(getKind());
-	opt->len  = htons(packedSize());
 }
 
-void Option::incrementalParse(void *buf, OptionSet *optionSet)
+/* indexed by kind */
+template <typename SET>
+struct OptionTable
 {
-	SOCKS6Option *opt = rawOptCast<SOCKS6Option>(buf);
-	uint16_t kind = ntohs(opt->kind);
+	static constexpr int KINDS = SOCKS6_OPTION_IDEMPOTENCE_REJECT + 1;
+	
+	OptionHandler<SET> handlers[KINDS] = {};
+	
+	template <typename OPT>
+	constexpr void add()
+	{
+		handlers[OPT::KIND] = OptionHandler<SET>::template of<OPT>();
+	}
 	
-	switch (kind)
+	constexpr OptionTable()
 	{
-	case SOCKS6_OPTION_STACK:
-		StackOption::incrementalParse(opt, optionSet);
-		break;
+		add<StackOption>();
+		
+		add<AuthMethodAdvertOption>();
+		add<AuthMethodSelectOption>();
 		
-	case SOCKS6_OPTION_AUTH_METHOD_ADVERT:
-		AuthMethodAdvertOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_AUTH_METHOD_SELECT:
-		AuthMethodSelectOption::incrementalParse(opt, optionSet);
-		break;
+		add<AuthDataOption>();
 		
-	case SOCKS6_OPTION_AUTH_DATA:
-		AuthDataOption::incrementalParse(opt, optionSet);
-		break;
+		add<SessionRequestOption>();
+		add<SessionIDOption>();
+		add<SessionUntrustedOption>();
+		add<SessionOKOption>();
+		add<SessionInvalidOption>();
+		add<SessionTeardownOption>();
 		
-	case SOCKS6_OPTION_SESSION_REQUEST:
-		SessionRequestOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_SESSION_ID:
-		SessionIDOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_SESSION_UNTRUSTED:
-		SessionUntrustedOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_SESSION_OK:
-		SessionOKOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_SESSION_INVALID:
-		SessionInvalidOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_SESSION_TEARDOWN:
-		SessionTeardownOption::incrementalParse(opt, optionSet);
-		break;
+		add<IdempotenceRequestOption>();
+		add<IdempotenceWindowOption>();
+		add<IdempotenceExpenditureOption>();
+		add<IdempotenceAcceptedOption>();
+		add<IdempotenceRejectedOption>();
+	}
+};
 
-	case SOCKS6_OPTION_IDEMPOTENCE_REQ:
-		IdempotenceRequestOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_IDEMPOTENCE_WND:
-		IdempotenceWindowOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_IDEMPOTENCE_EXPEND:
-		IdempotenceExpenditureOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_IDEMPOTENCE_ACCEPT:
-		IdempotenceAcceptedOption::incrementalParse(opt, optionSet);
-		break;
-	case SOCKS6_OPTION_IDEMPOTENCE_REJECT:
-		IdempotenceRejectedOption::incrementalParse(opt, optionSet);
-		break;
+template <typename SET>
+static constexpr OptionTable<SET> OPTION_TABLE;
 
-	default:
-		throw invalid_argument("Unknown kind");
+template <typename SET>
+ParseResult Option::incrementalParse(void *buf, SET *optionSet) noexcept
+{
+	SOCKS6Option *opt = reinterpret_cast<SOCKS6Option *>(buf);
+	uint16_t kind = ntohs(opt->kind);
+	ParseResult result;
+	
+	try
+	{
+		if (kind < OptionTable<SET>::KINDS)
+			result = OPTION_TABLE<SET>.handlers[kind](opt, optionSet);
+		else if (kind >= SOCKS6_OPTION_VENDOR_MIN)
+			result = VendorOption::incrementalParse(opt, optionSet->getMode());
+		else
+			result = PR_INVALID;
 	}
+	catch (bad_alloc &)
+	{
+		result = PR_ALLOC;
+	}
+	
+	S6M_PROBE(option, kind, ntohs(opt->len), result);
+	return result;
 }
 
+template ParseResult Option::incrementalParse(void *buf, OptionSet *optionSet) noexcept;
+template ParseResult Option::incrementalParse(void *buf, OptionSetView *optionSet) noexcept;
+
 Option::~Option() {}
 
 }
@@ -2,35 +2,37 @@
 #define SOCKS6MSG_OPTION_HH
 
 #include <arpa/inet.h>
-#include <set>
 #include <vector>
 #include <stdexcept>
-#include <boost/intrusive/list.hpp>
 #include "socks6.h"
 #include "bytebuffer.hh"
+#include "parseresult.hh"
 #include "usrpasswd.hh"
 
 namespace S6M
 {
 
 class OptionSet;
+class OptionSetView;
 
-class Option: public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>
+class Option
 {
 	SOCKS6OptionKind kind;
 	
 protected:
+	/* everything but the length, which pack() fills in */
 	virtual void fill(uint8_t *buf) const;
 	
+	/* returns nullptr if the option is truncated or has spurious bytes at the end */
 	template <typename T>
-	static T *rawOptCast(void *buf, bool allowPayload = true)
+	static T *rawOptCast(void *buf, bool allowPayload = true) noexcept
 	{
 		size_t len = ntohs(((SOCKS6Option *)buf)->len);
 		
 		if (len < sizeof(T))
-			throw std::invalid_argument("Truncated option");
+			return nullptr;
 		if (!allowPayload && len != sizeof(T))
-			throw std::invalid_argument("Spurious bytes at the end of the option");
+			return nullptr;
 		
 		return (T *)buf;
 	}
@@ -45,12 +47,20 @@ public:
 	
 	void pack(ByteBuffer *bb) const
 	{
-		uint8_t *buf = bb->get<uint8_t>(packedSize());
+		size_t size = packedSize();
+		uint8_t *buf = bb->get<uint8_t>(size);
 		
 		fill(buf);
+		reinterpret_cast<SOCKS6Option *>(buf)->len = htons(size);
 	}
 	
-	static void incrementalParse(void *buf, OptionSet *optionSet);
+	/*
+	 * SET is OptionSet or OptionSetView.
+	 * PR_INVALID means the option was dropped; it does not affect the rest of the message.
+	 * Does not throw.
+	 */
+	template <typename SET>
+	static ParseResult incrementalParse(void *buf, SET *optionSet) noexcept;
 	
 	Option(SOCKS6OptionKind kind)
 		: kind(kind) {}
@@ -58,10 +68,48 @@ public:
 	virtual ~Option();
 };
 
+/*
+ * Entry in the option dispatch tables, filled in from the option class:
+ * OPT::RawOption is the smallest valid option; longer ones are accepted only if OPT::PAYLOAD.
+ * OPT::incrementalParse() can count on the length having been checked.
+ */
+template <typename SET>
+struct OptionHandler
+{
+	typedef ParseResult (*Function)(SOCKS6Option *opt, SET *optionSet);
+	
+	size_t   size    = 0;
+	bool     payload = false;
+	Function parse   = nullptr;
+	
+	template <typename OPT>
+	static constexpr OptionHandler of()
+	{
+		return { sizeof(typename OPT::RawOption), OPT::PAYLOAD, &OPT::template incrementalParse<SET> };
+	}
+	
+	ParseResult operator ()(SOCKS6Option *opt, SET *optionSet) const
+	{
+		size_t len = ntohs(opt->len);
+		
+		if (!parse || len < size)
+			return PR_INVALID;
+		if (!payload && len != size)
+			return PR_INVALID;
+		
+		return parse(opt, optionSet);
+	}
+};
+
 template <typename T, SOCKS6OptionKind K>
 class SimpleOptionBase: public Option
 {
 public:
+	static constexpr SOCKS6OptionKind KIND    = K;
+	static constexpr bool             PAYLOAD = false;
+	
+	typedef SOCKS6Option RawOption;
+	
 	SimpleOptionBase()
 		: Option(K) {}
 
@@ -70,13 +118,14 @@ public:
 		return sizeof(SOCKS6Option);
 	}
 
-	static void incrementalParse(SOCKS6Option *optBase, OptionSet *optionSet)
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *, SET *optionSet)
 	{
-		rawOptCast<SOCKS6Option>(optBase, false);
-		T::simpleParse(optionSet);
+		return T::simpleParse(optionSet) ? PR_SUCCESS : PR_INVALID;
 	}
 
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 }
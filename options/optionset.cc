@@ -1,4 +1,5 @@
 #include "optionset.hh"
+#include "optionsetview.hh"
 
 using namespace std;
 
@@ -6,43 +7,203 @@ namespace S6M
 {
 
 OptionSet::OptionSet(ByteBuffer *bb, Mode mode, uint16_t optionsLength)
-	: OptionSetBase(this, mode)
+	: OptionSet(mode)
 {
-	if (optionsLength > SOCKS6_OPTIONS_LENGTH_MAX)
-		throw invalid_argument("Options length exceeds maximum value");
-	if (optionsLength % SOCKS6_ALIGNMENT)
-		throw invalid_argument("Options length not a multiple of " + SOCKS6_ALIGNMENT);
+	enforceParseResult(parse(bb, optionsLength), bb);
+}
+
+/* kinds already seen in the message help tell duplicates from other rejects */
+static ParseStats::Drop dropReason(uint16_t kind, uint64_t seen) noexcept
+{
+	if ((kind == 0 || kind >= ParseStats::KINDS) && kind < SOCKS6_OPTION_VENDOR_MIN)
+		return ParseStats::DROP_UNKNOWN;
+	if (kind < 64 && (seen & (1ULL << kind)))
+		return ParseStats::DROP_DUPLICATE;
+	return ParseStats::DROP_REJECTED;
+}
 
-	ByteBuffer optsBB(bb->get<uint8_t>(optionsLength), optionsLength);
+/* each option is fetched whole, so that over a ScatterBuffer only options that straddle segments get copied */
+template <typename BUFFER, typename SET>
+static ParseResult parseOptions(BUFFER *bb, uint16_t optionsLength, SET *optionSet) noexcept
+{
+	ParseResult result = OptionSet::checkLength(optionsLength);
+	if (result != PR_SUCCESS)
+		return result;
+
+	if (bb->getTotalSize() - bb->getUsed() < optionsLength)
+		return PR_BUFFER;
+	BUFFER optsBB(*bb);
+	size_t left = optionsLength;
+	uint64_t seen = 0;
+	int dropped = 0;
 	
-	while (optsBB.getUsed() < optsBB.getTotalSize())
+	while (left >= sizeof(SOCKS6Option))
 	{
-		SOCKS6Option *opt;
+		SOCKS6Option *head = optsBB.template tryPeek<SOCKS6Option>();
+		if (!head)
+			return PR_BUFFER;
 
-		try
+		/* bad option length wrecks remaining options */
+		size_t optLen = ntohs(head->len);
+		if (optLen < sizeof(SOCKS6Option) || optLen > left)
 		{
-			opt = optsBB.get<SOCKS6Option>();
-
-			/* bad option length wrecks remaining options */
-			size_t optLen = ntohs(opt->len);
-			if (optLen < sizeof(SOCKS6Option))
-				throw length_error("Option too short");
-			if (optLen % SOCKS6_ALIGNMENT != 0)
-				throw length_error("Option not aligned");
-
-			optsBB.get<uint8_t>(optLen - sizeof(SOCKS6Option));
+			ParseStats::drop(ParseStats::DROP_TRUNCATED);
+			break;
 		}
-		catch (length_error &)
+		if (optLen % SOCKS6_ALIGNMENT != 0)
 		{
+			ParseStats::drop(ParseStats::DROP_MISALIGNED);
 			break;
 		}
+		SOCKS6Option *opt = reinterpret_cast<SOCKS6Option *>(optsBB.template tryGet<uint8_t>(optLen));
+		if (!opt)
+			return PR_BUFFER;
+		left -= optLen;
+		
+		uint16_t kind = ntohs(opt->kind);
+		ParseStats::option(kind);
 		
-		try
+		/* bad options are dropped */
+		result = Option::incrementalParse(opt, optionSet);
+		if (result == PR_ALLOC)
+			return PR_ALLOC;
+		if (result != PR_SUCCESS)
+			ParseStats::drop(dropReason(kind, seen));
+		if (kind < 64)
+			seen |= 1ULL << kind;
+		
+		/* the rest is left to the trySkip() below */
+		if (result != PR_SUCCESS && ++dropped == OptionSet::MAX_DROPPED && left > 0)
 		{
-			Option::incrementalParse(opt, this);
+			ParseStats::drop(ParseStats::DROP_EXCESS);
+			break;
 		}
-		catch (invalid_argument &) {}
 	}
+	
+	/* keeps whatever scratch the options were copied to */
+	*bb = optsBB;
+	bb->trySkip(left);
+	return PR_SUCCESS;
+}
+
+template <typename BUFFER>
+ParseResult OptionSet::parse(BUFFER *bb, uint16_t optionsLength) noexcept
+{
+	return parseOptions(bb, optionsLength, this);
+}
+
+static void packSessionID(ByteBuffer *bb, const SessionID &id)
+{
+	SessionIDOption(id).pack(bb);
+}
+
+static void packSessionID(GatherBuffer *gb, const SessionID &id)
+{
+	SOCKS6SessionIDOption *opt = gb->get<SOCKS6SessionIDOption>();
+	opt->optionHead.kind = htons(SOCKS6_OPTION_SESSION_ID);
+	opt->optionHead.len  = htons(SessionIDOption::sizeOf(id.size()));
+	
+	gb->append(id.data(), id.size());
+}
+
+template <typename BUFFER>
+void SessionOptionSet::pack(BUFFER *bb) const
+{
+	if (present & REQUEST)
+		SessionRequestOption().pack(bb);
+	if (present & ID)
+		packSessionID(bb, id);
+	if (present & OK)
+		SessionOKOption().pack(bb);
+	if (present & INVALID)
+		SessionInvalidOption().pack(bb);
+	if (present & TEARDOWN)
+		SessionTeardownOption().pack(bb);
+	if (present & UNTRUSTED)
+		SessionUntrustedOption().pack(bb);
 }
 
+void IdempotenceOptionSet::pack(ByteBuffer *bb) const
+{
+	if (present & REQUEST)
+		IdempotenceRequestOption(requestSize).pack(bb);
+	if (present & TOKEN)
+		IdempotenceExpenditureOption(token).pack(bb);
+	if (present & WINDOW)
+		IdempotenceWindowOption({ windowBase, windowSize }).pack(bb);
+	if (present & ACCEPTED)
+		IdempotenceAcceptedOption().pack(bb);
+	if (present & REJECTED)
+		IdempotenceRejectedOption().pack(bb);
+}
+
+static void packCredentials(ByteBuffer *bb, const pair<string_view, string_view> &creds)
+{
+	UsernamePasswdReqOption(creds).pack(bb);
+}
+
+static void packCredentials(GatherBuffer *gb, const pair<string_view, string_view> &creds)
+{
+	size_t size = UsernamePasswdReqOption::sizeOf(creds);
+	
+	SOCKS6AuthDataOption *opt = gb->get<SOCKS6AuthDataOption>();
+	opt->optionHead.kind = htons(SOCKS6_OPTION_AUTH_DATA);
+	opt->optionHead.len  = htons(size);
+	opt->method          = SOCKS6_METHOD_USRPASSWD;
+	
+	/* same layout as UserPasswordRequest */
+	*gb->get<uint8_t>() = SOCKS6_USERPASSWD_VERSION;
+	*gb->get<uint8_t>() = creds.first.length();
+	gb->append(reinterpret_cast<const uint8_t *>(creds.first.data()), creds.first.length());
+	*gb->get<uint8_t>() = creds.second.length();
+	gb->append(reinterpret_cast<const uint8_t *>(creds.second.data()), creds.second.length());
+	
+	size_t padding = size - (sizeof(SOCKS6AuthDataOption) + 3 + creds.first.length() + creds.second.length());
+	memset(gb->get<uint8_t>(padding), 0, padding);
+}
+
+template <typename BUFFER>
+void UserPasswdOptionSet::pack(BUFFER *bb) const
+{
+	if (present & CREDENTIALS)
+		packCredentials(bb, getCredentials());
+	if (present & (SUCCESS | FAILURE))
+		UsernamePasswdReplyOption(present & SUCCESS).pack(bb);
+}
+
+void AuthMethodOptionSet::pack(ByteBuffer *bb) const
+{
+	if (present & ADVERTISED)
+		AuthMethodAdvertOption(initialDataLen, methods).pack(bb);
+	if (present & SELECTED)
+		AuthMethodSelectOption(selected).pack(bb);
+}
+
+template <typename BUFFER>
+void OptionSet::pack(BUFFER *bb) const
+{
+	stack.pack(bb);
+	session.pack(bb);
+	idempotence.pack(bb);
+	authMethods.pack(bb);
+	userPassword.pack(bb);
+}
+
+template <typename BUFFER>
+ParseResult OptionSetView::parse(BUFFER *bb, uint16_t optionsLength) noexcept
+{
+	return parseOptions(bb, optionsLength, this);
+}
+
+template void SessionOptionSet::pack(ByteBuffer *bb) const;
+template void SessionOptionSet::pack(GatherBuffer *bb) const;
+template void UserPasswdOptionSet::pack(ByteBuffer *bb) const;
+template void UserPasswdOptionSet::pack(GatherBuffer *bb) const;
+template void OptionSet::pack(ByteBuffer *bb) const;
+template void OptionSet::pack(GatherBuffer *bb) const;
+template ParseResult OptionSet::parse(ByteBuffer *bb, uint16_t optionsLength) noexcept;
+template ParseResult OptionSet::parse(ScatterBuffer *bb, uint16_t optionsLength) noexcept;
+template ParseResult OptionSetView::parse(ByteBuffer *bb, uint16_t optionsLength) noexcept;
+template ParseResult OptionSetView::parse(ScatterBuffer *bb, uint16_t optionsLength) noexcept;
+
 }
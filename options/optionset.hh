@@ -2,10 +2,8 @@
 #define SOCKS6MSG_OPTIONSET_HH
 
 #include <string>
-#include <list>
-#include <map>
+#include <memory_resource>
 #include <vector>
-#include <set>
 #include <algorithm>
 #include <optional>
 #include <variant>
@@ -15,228 +13,268 @@
 #include "authmethodoption.hh"
 #include "authdataoption.hh"
 #include "sessionoption.hh"
+#include "span.hh"
+#include "gatherbuffer.hh"
+#include "scatterbuffer.hh"
+#include "parsestats.hh"
 
 namespace S6M
 {
 
-//TODO: this is waaaaaay too bloated
-
-class OptionList
-{
-protected:
-	boost::intrusive::list<Option, boost::intrusive::constant_time_size<false>> options;
-	size_t optionsSize = 0;
-	
-public:
-	void registerOption(Option *option)
-	{
-		if (optionsSize + option->packedSize() > SOCKS6_OPTIONS_LENGTH_MAX)
-			throw std::length_error("Option would not fit");
-		options.push_back(*option);
-		optionsSize += option->packedSize();
-	}
-};
+/*
+ * Option sets keep presence bitmaps and plain values.
+ * Option objects are only built when packing.
+ */
 
 class OptionSetBase
 {
 public:
-	enum Mode
+	enum Mode: uint8_t
 	{
 		M_REQ,
 		M_AUTH_REP,
 		M_OP_REP,
 	};
 	
+	/* shared by an option set and its sub-sets */
+	struct Header
+	{
+		Mode     mode;
+		uint16_t size; /* all options, packed */
+	};
+	
 protected:
-	OptionList *optionList;
-	Mode mode;
+	Header *header;
 	
-	void enforceMode(Mode mode1) const
+	bool permits(Mode mode1) const
 	{
-		if (mode != mode1)
-			throw std::logic_error("Option not available");
+		return header->mode == mode1;
 	}
 	
-	void enforceMode(Mode mode1, Mode mode2) const
+	bool permits(Mode mode1, Mode mode2) const
 	{
-		if (mode != mode1 && mode != mode2)
-			throw std::logic_error("Option not available");
+		return header->mode == mode1 || header->mode == mode2;
 	}
 	
-	template <typename T>
-	static T &vacant(T &t)
+	void enforceMode(Mode mode1) const
 	{
-		if (t)
-			throw std::logic_error("Option already in place");
-		return t;
+		if (!permits(mode1))
+			throw std::logic_error("Option not available");
 	}
 	
-	template <typename T>
-	static T &vacantVariant(T &t)
+	void enforceMode(Mode mode1, Mode mode2) const
 	{
-		if (!std::holds_alternative<std::monostate>(t))
-			throw std::logic_error("Option already in place");
-		return t;
+		if (!permits(mode1, mode2))
+			throw std::logic_error("Option not available");
 	}
 	
-	template <typename T, typename... ARG>
-	void commitEmplace(std::optional<T> &field, ARG... arg)
+	/*
+	 * Marks flag as present and accounts for size bytes of options.
+	 * Fails if flag or any of the conflicting flags is already present, or if the option doesn't fit.
+	 */
+	bool tryClaim(uint8_t &present, uint8_t flag, size_t size, uint8_t conflicts = 0) noexcept
 	{
-		vacant(field).emplace(arg...);
-		try
-		{
-			optionList->registerOption(&field.value());
-		}
-		catch (...)
-		{
-			field.reset();
-			throw;
-		}
+		if (present & (flag | conflicts))
+			return false;
+		if (header->size + size > SOCKS6_OPTIONS_LENGTH_MAX)
+			return false;
+		
+		present |= flag;
+		header->size += size;
+		return true;
 	}
 	
-	template <typename T, typename L>
-	void commit(std::optional<T> &field, L lambda)
+	void claim(uint8_t &present, uint8_t flag, size_t size, uint8_t conflicts = 0)
 	{
-		vacant(field) = lambda();
-		try
-		{
-			optionList->registerOption(&field.value());
-		}
-		catch (...)
-		{
-			field.reset();
-			throw;
-		}
+		if (present & (flag | conflicts))
+			throw std::logic_error("Option already in place");
+		if (!tryClaim(present, flag, size, conflicts))
+			throw std::length_error("Option would not fit");
 	}
 	
-	template <typename T, typename L>
-	void commit(std::optional<T> &field1, std::optional<T> &field2, L lambda)
+	/* undoes a claim if the value can't be stored */
+	void release(uint8_t &present, uint8_t flag, size_t size) noexcept
 	{
-		vacant(field1);
-		vacant(field2) = lambda();
-		field1 = field2;
-		try
-		{
-			optionList->registerOption(&field1.value());
-		}
-		catch (...)
-		{
-			field1.reset();
-			field2.reset();
-			throw;
-		}
+		present &= ~flag;
+		header->size -= size;
 	}
 	
-	template <typename V, typename L>
-	void commitVariant(V &field, L lambda)
+	template <typename OPT>
+	static constexpr size_t fixedSize()
 	{
-		vacantVariant(field) = lambda();
-		try
-		{
-			optionList->registerOption(std::get_if<decltype(lambda())>(&field));
-		}
-		catch (...)
-		{
-			field = std::monostate();
-			throw;
-		}
+		static_assert(!OPT::PAYLOAD, "Option has variable size");
+		return sizeof(typename OPT::RawOption);
 	}
 	
 public:
-	OptionSetBase(OptionList *optionList, Mode mode)
-		: optionList(optionList), mode(mode) {}
+	OptionSetBase(Header *header)
+		: header(header) {}
 };
 
 class SessionOptionSet: public OptionSetBase
 {
-	std::variant<std::monostate, SessionRequestOption, SessionIDOption, SessionOKOption, SessionInvalidOption> mandatoryOpt;
-
-	std::optional<SessionTeardownOption>  teardownOpt;
-	std::optional<SessionUntrustedOption> untrustedOpt;
+	enum Flag: uint8_t
+	{
+		REQUEST   = 1 << 0,
+		ID        = 1 << 1,
+		OK        = 1 << 2,
+		INVALID   = 1 << 3,
+		TEARDOWN  = 1 << 4,
+		UNTRUSTED = 1 << 5,
+	};
+	
+	/* at most one of these */
+	static constexpr uint8_t MANDATORY = REQUEST | ID | OK | INVALID;
+	
+	uint8_t   present = 0;
+	SessionID id;
 	
 public:
-	using OptionSetBase::OptionSetBase;
+	SessionOptionSet(Header *header, std::pmr::memory_resource *resource)
+		: OptionSetBase(header), id(SessionID::allocator_type(resource)) {}
 	
 	void request()
 	{
 		enforceMode(M_REQ);
-		commitVariant(mandatoryOpt, []() { return SessionRequestOption(); });
+		claim(present, REQUEST, fixedSize<SessionRequestOption>(), MANDATORY);
+	}
+	
+	bool tryRequest()
+	{
+		return permits(M_REQ) && tryClaim(present, REQUEST, fixedSize<SessionRequestOption>(), MANDATORY);
 	}
 	
 	bool requested() const
 	{
-		return std::holds_alternative<SessionRequestOption>(mandatoryOpt);
+		return present & REQUEST;
 	}
 	
 	void tearDown()
 	{
 		enforceMode(M_REQ);
-		commitEmplace(teardownOpt);
+		claim(present, TEARDOWN, fixedSize<SessionTeardownOption>());
+	}
+	
+	bool tryTearDown()
+	{
+		return permits(M_REQ) && tryClaim(present, TEARDOWN, fixedSize<SessionTeardownOption>());
 	}
 	
 	bool tornDown() const
 	{
-		return (bool)teardownOpt;
+		return present & TEARDOWN;
 	}
 	
 	void setID(const SessionID &id)
 	{
 		enforceMode(M_REQ, M_AUTH_REP);
-		commitVariant(mandatoryOpt, [&]() { return SessionIDOption(id); });
+		
+		size_t size = SessionIDOption(id).packedSize();
+		claim(present, ID, size, MANDATORY);
+		try
+		{
+			this->id = id;
+		}
+		catch (...)
+		{
+			release(present, ID, size);
+			throw;
+		}
+	}
+	
+	bool trySetID(Span<const uint8_t> ticket)
+	{
+		size_t size = SessionIDOption::sizeOf(ticket.size());
+		if (!permits(M_REQ, M_AUTH_REP) || !tryClaim(present, ID, size, MANDATORY))
+			return false;
+		try
+		{
+			id.assign(ticket.begin(), ticket.end());
+		}
+		catch (...)
+		{
+			release(present, ID, size);
+			throw;
+		}
+		return true;
 	}
 	
 	const SessionID *getID() const
 	{
-		enforceMode(M_REQ, M_AUTH_REP);
-		
-		const SessionIDOption *opt = std::get_if<SessionIDOption>(&mandatoryOpt);
-		if (!opt)
+		if (!(present & ID))
 			return nullptr;
-		return opt->getID();
+		return &id;
 	}
 	
 	void signalOK()
 	{
 		enforceMode(M_AUTH_REP);
-		commitVariant(mandatoryOpt, []() { return SessionOKOption(); });
+		claim(present, OK, fixedSize<SessionOKOption>(), MANDATORY);
+	}
+	
+	bool trySignalOK()
+	{
+		return permits(M_AUTH_REP) && tryClaim(present, OK, fixedSize<SessionOKOption>(), MANDATORY);
 	}
 	
 	bool isOK() const
 	{
-		return std::holds_alternative<SessionOKOption>(mandatoryOpt);
+		return present & OK;
 	}
 	
 	void signalReject()
 	{
 		enforceMode(M_AUTH_REP);
-		commitVariant(mandatoryOpt, []() { return SessionInvalidOption(); });
+		claim(present, INVALID, fixedSize<SessionInvalidOption>(), MANDATORY);
+	}
+	
+	bool trySignalReject()
+	{
+		return permits(M_AUTH_REP) && tryClaim(present, INVALID, fixedSize<SessionInvalidOption>(), MANDATORY);
 	}
 	
 	bool rejected() const
 	{
-		return std::holds_alternative<SessionInvalidOption>(mandatoryOpt);
+		return present & INVALID;
 	}
 	
 	void setUntrusted()
 	{
 		enforceMode(M_REQ);
-		commitEmplace(untrustedOpt);
+		claim(present, UNTRUSTED, fixedSize<SessionUntrustedOption>());
+	}
+	
+	bool trySetUntrusted()
+	{
+		return permits(M_REQ) && tryClaim(present, UNTRUSTED, fixedSize<SessionUntrustedOption>());
 	}
 	
 	bool isUntrusted() const
 	{
-		return (bool)untrustedOpt;
+		return present & UNTRUSTED;
 	}
+	
+	/* BUFFER is ByteBuffer or GatherBuffer; the latter references the ID */
+	template <typename BUFFER>
+	void pack(BUFFER *bb) const;
 };
 
 class IdempotenceOptionSet: public OptionSetBase
 {
-	std::optional<IdempotenceRequestOption>     requestOpt;
-	std::optional<IdempotenceExpenditureOption> expenditureOpt;
-
-	std::optional<IdempotenceWindowOption> windowOpt;
-
-	std::variant<std::monostate, IdempotenceAcceptedOption, IdempotenceRejectedOption> replyOpt;
+	enum Flag: uint8_t
+	{
+		REQUEST  = 1 << 0,
+		TOKEN    = 1 << 1,
+		WINDOW   = 1 << 2,
+		ACCEPTED = 1 << 3,
+		REJECTED = 1 << 4,
+	};
+	
+	uint8_t  present = 0;
+	uint32_t requestSize;
+	uint32_t token;
+	uint32_t windowBase;
+	uint32_t windowSize;
 	
 public:
 	using OptionSetBase::OptionSetBase;
@@ -244,106 +282,193 @@ public:
 	void request(uint32_t size)
 	{
 		enforceMode(M_REQ);
-		commitEmplace(requestOpt, size);
+		WindowSize checked(size);
+		claim(present, REQUEST, fixedSize<IdempotenceRequestOption>());
+		requestSize = checked;
+	}
+	
+	bool tryRequest(uint32_t size)
+	{
+		if (!permits(M_REQ) || !tryClaim(present, REQUEST, fixedSize<IdempotenceRequestOption>()))
+			return false;
+		requestSize = size;
+		return true;
 	}
 	
 	uint32_t requestedSize() const
 	{
-		if (!requestOpt)
+		if (!(present & REQUEST))
 			return 0;
-		return requestOpt->getWinSize();
+		return requestSize;
 	}
 	
 	void setToken(uint32_t token)
 	{
 		enforceMode(M_REQ);
-		commitEmplace(expenditureOpt, token);
+		claim(present, TOKEN, fixedSize<IdempotenceExpenditureOption>());
+		this->token = token;
+	}
+	
+	bool trySetToken(uint32_t token)
+	{
+		if (!permits(M_REQ) || !tryClaim(present, TOKEN, fixedSize<IdempotenceExpenditureOption>()))
+			return false;
+		this->token = token;
+		return true;
 	}
 	
 	std::optional<uint32_t> getToken() const
 	{
-		if (!expenditureOpt)
+		if (!(present & TOKEN))
 			return {};
-		return expenditureOpt->getToken();
+		return token;
 	}
 	
 	void advertise(std::pair<uint32_t, uint32_t> window)
 	{
 		enforceMode(M_AUTH_REP);
-		commitEmplace(windowOpt, window);
+		WindowSize checked(window.second);
+		claim(present, WINDOW, fixedSize<IdempotenceWindowOption>());
+		windowBase = window.first;
+		windowSize = checked;
+	}
+	
+	bool tryAdvertise(std::pair<uint32_t, uint32_t> window)
+	{
+		if (!permits(M_AUTH_REP) || !tryClaim(present, WINDOW, fixedSize<IdempotenceWindowOption>()))
+			return false;
+		windowBase = window.first;
+		windowSize = window.second;
+		return true;
 	}
 	
 	std::pair<uint32_t, uint32_t> getAdvertised() const
 	{
-		if (!windowOpt)
+		if (!(present & WINDOW))
 			return { 0, 0 };
-		return windowOpt->getWindow();
+		return { windowBase, windowSize };
 	}
 	
 	void setReply(bool accepted)
 	{
 		enforceMode(M_AUTH_REP);
 		if (accepted)
-		{
-			commitVariant(replyOpt, []() { return IdempotenceAcceptedOption(); });
-		}
+			claim(present, ACCEPTED, fixedSize<IdempotenceAcceptedOption>(), REJECTED);
 		else
-		{
-			commitVariant(replyOpt, []() { return IdempotenceRejectedOption(); });
-		}
+			claim(present, REJECTED, fixedSize<IdempotenceRejectedOption>(), ACCEPTED);
+	}
+	
+	bool trySetReply(bool accepted)
+	{
+		if (!permits(M_AUTH_REP))
+			return false;
+		if (accepted)
+			return tryClaim(present, ACCEPTED, fixedSize<IdempotenceAcceptedOption>(), REJECTED);
+		else
+			return tryClaim(present, REJECTED, fixedSize<IdempotenceRejectedOption>(), ACCEPTED);
 	}
 	
 	std::optional<bool> getReply() const
 	{
-		if (std::holds_alternative<IdempotenceAcceptedOption>(replyOpt))
+		if (present & ACCEPTED)
 			return true;
-		if (std::holds_alternative<IdempotenceRejectedOption>(replyOpt))
+		if (present & REJECTED)
 			return false;
 		return {};
 	}
+	
+	void pack(ByteBuffer *bb) const;
 };
 
 template <typename OPT>
 class StackOptionPair: public OptionSetBase
 {
-	std::optional<OPT> clientProxy;
-	std::optional<OPT> proxyRemote;
+	typedef typename OPT::Value Value;
+	
+	enum Flag: uint8_t
+	{
+		CLIENT_PROXY = 1 << 0,
+		PROXY_REMOTE = 1 << 1,
+		/* both legs set by a single option */
+		BOTH         = 1 << 2,
+	};
+	
+	uint8_t present = 0;
+	
+	/* not every Value is default-constructible */
+	std::optional<Value> clientProxy;
+	std::optional<Value> proxyRemote;
+	
+	static constexpr bool legAllowed(SOCKS6StackLeg leg)
+	{
+		return OPT::LEG_RESTRICT == SOCKS6_STACK_LEG_BOTH || leg == OPT::LEG_RESTRICT;
+	}
 	
 public:
 	typedef OPT Option;
 	
 	using OptionSetBase::OptionSetBase;
 	
-	void set(SOCKS6StackLeg leg, typename OPT::Value value)
+	void set(SOCKS6StackLeg leg, Value value)
 	{
 		enforceMode(M_REQ, M_AUTH_REP);
-		switch(leg)
+		/* validates leg */
+		OPT opt(leg, value);
+		
+		switch (leg)
 		{
 		case SOCKS6_STACK_LEG_CLIENT_PROXY:
-			commit(clientProxy, [&]() { return OPT(leg, value); });
+			claim(present, CLIENT_PROXY, fixedSize<OPT>());
+			clientProxy = value;
 			return;
 		case SOCKS6_STACK_LEG_PROXY_REMOTE:
-			commit(proxyRemote, [&]() { return OPT(leg, value); });
+			claim(present, PROXY_REMOTE, fixedSize<OPT>());
+			proxyRemote = value;
 			return;
 		case SOCKS6_STACK_LEG_BOTH:
-			commit(clientProxy, proxyRemote, [&]() { return OPT(leg, value); });
+			claim(present, CLIENT_PROXY | PROXY_REMOTE | BOTH, fixedSize<OPT>());
+			clientProxy = value;
+			proxyRemote = value;
 			return;
 		}
 	}
 	
-	std::optional<typename OPT::Value> get(SOCKS6StackLeg leg) const
+	bool trySet(SOCKS6StackLeg leg, Value value)
+	{
+		if (!permits(M_REQ, M_AUTH_REP) || !legAllowed(leg))
+			return false;
+		
+		switch (leg)
+		{
+		case SOCKS6_STACK_LEG_CLIENT_PROXY:
+			if (!tryClaim(present, CLIENT_PROXY, fixedSize<OPT>()))
+				return false;
+			clientProxy = value;
+			return true;
+		case SOCKS6_STACK_LEG_PROXY_REMOTE:
+			if (!tryClaim(present, PROXY_REMOTE, fixedSize<OPT>()))
+				return false;
+			proxyRemote = value;
+			return true;
+		case SOCKS6_STACK_LEG_BOTH:
+			if (!tryClaim(present, CLIENT_PROXY | PROXY_REMOTE | BOTH, fixedSize<OPT>()))
+				return false;
+			clientProxy = value;
+			proxyRemote = value;
+			return true;
+		}
+		return false;
+	}
+	
+	std::optional<Value> get(SOCKS6StackLeg leg) const
 	{
 		switch(leg)
 		{
 		case SOCKS6_STACK_LEG_CLIENT_PROXY:
-			if (!clientProxy)
-				return {};
-			return clientProxy->getValue();
+			return clientProxy;
 			
 		case SOCKS6_STACK_LEG_PROXY_REMOTE:
-			if (!proxyRemote)
-				return {};
-			return clientProxy->getValue();
+			return proxyRemote;
 			
 		case SOCKS6_STACK_LEG_BOTH:
 			throw std::logic_error("Bad leg");
@@ -352,144 +477,285 @@ public:
 	}
 	
 	template <SOCKS6StackLeg LEG = OPT::LEG_RESTRICT>
-	void set(typename OPT::Value value)
+	void set(Value value)
 	{
 		set(LEG, value);
 	}
 	
 	template <SOCKS6StackLeg LEG = OPT::LEG_RESTRICT>
-	std::optional<typename OPT::Value> get() const
+	std::optional<Value> get() const
 	{
 		static_assert (LEG != SOCKS6_STACK_LEG_BOTH, "Option is not restricted to one leg");
 		return get(OPT::LEG_RESTRICT);
 	}
+	
+	void pack(ByteBuffer *bb) const
+	{
+		if (present & BOTH)
+		{
+			OPT(SOCKS6_STACK_LEG_BOTH, *clientProxy).pack(bb);
+			return;
+		}
+		if (clientProxy)
+			OPT(SOCKS6_STACK_LEG_CLIENT_PROXY, *clientProxy).pack(bb);
+		if (proxyRemote)
+			OPT(SOCKS6_STACK_LEG_PROXY_REMOTE, *proxyRemote).pack(bb);
+	}
 };
 
-struct StackOptionSet: public OptionSetBase
+struct StackOptionSet
 {
-	StackOptionPair<TOSOption>     tos     { optionList, mode };
-	StackOptionPair<TFOOption>     tfo     { optionList, mode };
-	StackOptionPair<MPOption>      mp      { optionList, mode };
-	StackOptionPair<BacklogOption> backlog { optionList, mode };
+	StackOptionPair<TOSOption>     tos;
+	StackOptionPair<TFOOption>     tfo;
+	StackOptionPair<MPOption>      mp;
+	StackOptionPair<BacklogOption> backlog;
 	
-	using OptionSetBase::OptionSetBase;
+	StackOptionSet(OptionSetBase::Header *header)
+		: tos(header), tfo(header), mp(header), backlog(header) {}
+	
+	void pack(ByteBuffer *bb) const
+	{
+		tos.pack(bb);
+		tfo.pack(bb);
+		mp.pack(bb);
+		backlog.pack(bb);
+	}
 };
 
 class UserPasswdOptionSet: public OptionSetBase
 {
-	std::optional<UsernamePasswdReqOption>   req;
-	std::optional<UsernamePasswdReplyOption> reply;
+	enum Flag: uint8_t
+	{
+		CREDENTIALS = 1 << 0,
+		SUCCESS     = 1 << 1,
+		FAILURE     = 1 << 2,
+	};
+	
+	uint8_t present = 0;
+	uint8_t usernameLength;
+	
+	/* username immediately followed by password */
+	std::pmr::string credentials;
 	
 public:
-	using OptionSetBase::OptionSetBase;
+	UserPasswdOptionSet(Header *header, std::pmr::memory_resource *resource)
+		: OptionSetBase(header), credentials(resource) {}
 	
 	void setCredentials(const std::pair<std::string_view, const std::string_view> &creds)
 	{
 		enforceMode(M_REQ);
-		commit(req, [&]() { return UsernamePasswdReqOption(creds); });
+		
+		size_t size = UsernamePasswdReqOption(creds).packedSize();
+		claim(present, CREDENTIALS, size);
+		try
+		{
+			credentials.assign(creds.first).append(creds.second);
+		}
+		catch (...)
+		{
+			release(present, CREDENTIALS, size);
+			throw;
+		}
+		usernameLength = creds.first.length();
+	}
+	
+	bool trySetCredentials(const std::pair<std::string_view, const std::string_view> &creds)
+	{
+		size_t size = UsernamePasswdReqOption::sizeOf(creds);
+		if (!permits(M_REQ) || !tryClaim(present, CREDENTIALS, size))
+			return false;
+		try
+		{
+			credentials.assign(creds.first).append(creds.second);
+		}
+		catch (...)
+		{
+			release(present, CREDENTIALS, size);
+			throw;
+		}
+		usernameLength = creds.first.length();
+		return true;
 	}
 	
 	std::pair<std::string_view, std::string_view> getCredentials() const
 	{
-		if (!req)
+		if (!(present & CREDENTIALS))
 			return {};
-		return req->getCredentials();
+		
+		std::string_view all(credentials);
+		return { all.substr(0, usernameLength), all.substr(usernameLength) };
 	}
 	
 	void setReply(bool success)
 	{
 		enforceMode(M_AUTH_REP);
-		commitEmplace(reply, success);
+		claim(present, success ? SUCCESS : FAILURE, UsernamePasswdReplyOption::sizeOf(), SUCCESS | FAILURE);
+	}
+	
+	bool trySetReply(bool success)
+	{
+		return permits(M_AUTH_REP) && tryClaim(present, success ? SUCCESS : FAILURE, UsernamePasswdReplyOption::sizeOf(), SUCCESS | FAILURE);
 	}
 	
 	std::optional<bool> getReply() const
 	{
-		if (!reply)
-			return {};
-		return reply->isSuccessful();
+		if (present & SUCCESS)
+			return true;
+		if (present & FAILURE)
+			return false;
+		return {};
 	}
+	
+	/* BUFFER is ByteBuffer or GatherBuffer; the latter references the credentials */
+	template <typename BUFFER>
+	void pack(BUFFER *bb) const;
 };
 
 class AuthMethodOptionSet: public OptionSetBase
 {
-	std::optional<AuthMethodAdvertOption> advertOption;
-	std::optional<AuthMethodSelectOption> selectOption;
+	enum Flag: uint8_t
+	{
+		ADVERTISED = 1 << 0,
+		SELECTED   = 1 << 1,
+	};
+	
+	uint8_t        present = 0;
+	SOCKS6Method   selected;
+	uint16_t       initialDataLen;
+	AuthMethodMask methods;
 	
 public:
 	using OptionSetBase::OptionSetBase;
 	
-	const std::set<SOCKS6Method> *getAdvertised() const
+	/* NOAUTH is implied and never included */
+	const AuthMethodMask *getAdvertised() const
 	{
-		static const std::set<SOCKS6Method> EMPTY_SET;
-		if (!advertOption)
-			return &EMPTY_SET;
-		
-		return advertOption->getMethods();
+		return &methods;
 	}
 	
-	void advertise(const std::set<SOCKS6Method> &methods, uint16_t initialDataLen)
+	void advertise(const AuthMethodMask &methods, uint16_t initialDataLen)
 	{
 		enforceMode(M_REQ);
-		commit(advertOption, [&]() { return AuthMethodAdvertOption(initialDataLen, methods); });
+		
+		AuthMethodAdvertOption opt(initialDataLen, methods);
+		claim(present, ADVERTISED, opt.packedSize());
+		this->methods = *opt.getMethods();
+		this->initialDataLen = initialDataLen;
 	}
 
+	bool tryAdvertise(Span<const uint8_t> methods, uint16_t initialDataLen)
+	{
+		if (!permits(M_REQ))
+			return false;
+		
+		AuthMethodMask mask(methods);
+		mask.erase(SOCKS6_METHOD_NOAUTH);
+		
+		if (!tryClaim(present, ADVERTISED, AuthMethodAdvertOption::sizeOf(mask.size())))
+			return false;
+		this->methods = mask;
+		this->initialDataLen = initialDataLen;
+		return true;
+	}
+	
 	uint16_t getInitialDataLen() const
 	{
-		if (!advertOption)
+		if (!(present & ADVERTISED))
 			return 0;
-		return advertOption->getInitialDataLen();
+		return initialDataLen;
 	}
 	
 	void select(SOCKS6Method method)
 	{
 		enforceMode(M_AUTH_REP);
-		commitEmplace(selectOption, method);
+		/* validates method */
+		AuthMethodSelectOption opt(method);
+		claim(present, SELECTED, fixedSize<AuthMethodSelectOption>());
+		selected = method;
+	}
+	
+	bool trySelect(SOCKS6Method method)
+	{
+		if (!permits(M_AUTH_REP) || !tryClaim(present, SELECTED, fixedSize<AuthMethodSelectOption>()))
+			return false;
+		selected = method;
+		return true;
 	}
 	
 	SOCKS6Method getSelected() const
 	{
-		if (!selectOption)
+		if (!(present & SELECTED))
 			return SOCKS6_METHOD_NOAUTH;
-		return selectOption->getMethod();
+		return selected;
 	}
+	
+	void pack(ByteBuffer *bb) const;
 };
 
-struct OptionSet: protected OptionList, public OptionSetBase
+struct OptionSet: public OptionSetBase
 {
-	StackOptionSet       stack        { this, mode };
-	SessionOptionSet     session      { this, mode };
-	IdempotenceOptionSet idempotence  { this, mode };
-	UserPasswdOptionSet  userPassword { this, mode };
-	AuthMethodOptionSet  authMethods  { this, mode };
+protected:
+	Header header;
+	
+public:
+	StackOptionSet       stack;
+	SessionOptionSet     session;
+	IdempotenceOptionSet idempotence;
+	UserPasswdOptionSet  userPassword;
+	AuthMethodOptionSet  authMethods;
 	
-	OptionSet(Mode mode)
-		: OptionSetBase(this, mode) {}
+	/* the session ID and credentials are allocated from resource */
+	OptionSet(Mode mode, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: OptionSetBase(&header), header { mode, 0 },
+		  stack(&header), session(&header, resource), idempotence(&header), userPassword(&header, resource), authMethods(&header) {}
 	
 	OptionSet(ByteBuffer *bb, Mode mode, uint16_t optionsLength);
 	
-	/* intrusive lists fuck this up */
-	OptionSet(const OptionSet &) = delete;
+	/*
+	 * Expects an empty option set.
+	 * Bad options are dropped; only a bad options block fails.
+	 * Past MAX_DROPPED bad options, the rest of the block is skipped unread,
+	 * so that a block stuffed with junk costs about as much as an ordinary one.
+	 */
+	template <typename BUFFER>
+	ParseResult parse(BUFFER *bb, uint16_t optionsLength) noexcept;
 	
-	/* intrusive lists fuck this up */
-	OptionSet &operator =(const OptionSet &) = delete;
+	static constexpr int MAX_DROPPED = 16;
 	
-	void pack(ByteBuffer *bb) const
+	static ParseResult checkLength(uint16_t optionsLength) noexcept
 	{
-		for (const Option &option: options)
-			option.pack(bb);
+		/* options length exceeds maximum value */
+		if (optionsLength > SOCKS6_OPTIONS_LENGTH_MAX)
+			return PR_INVALID;
+		/* options length not a multiple of SOCKS6_ALIGNMENT */
+		if (optionsLength % SOCKS6_ALIGNMENT)
+			return PR_INVALID;
+		return PR_SUCCESS;
 	}
 	
+	/* sub-sets point to the header */
+	OptionSet(const OptionSet &) = delete;
+	
+	/* sub-sets point to the header */
+	OptionSet &operator =(const OptionSet &) = delete;
+	
+	/* BUFFER is ByteBuffer or GatherBuffer */
+	template <typename BUFFER>
+	void pack(BUFFER *bb) const;
+	
 	size_t packedSize() const
 	{
-		return optionsSize;
+		return header.size;
 	}
 	
 	Mode getMode() const
 	{
-		return mode;
+		return header.mode;
 	}
 };
 
+static_assert(sizeof(OptionSet) <= 384, "OptionSet outgrew its size budget");
+
 }
 
 #endif // SOCKS6MSG_OPTIONSET_HH
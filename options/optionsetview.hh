@@ -0,0 +1,356 @@
+#ifndef SOCKS6MSG_OPTIONSETVIEW_HH
+#define SOCKS6MSG_OPTIONSETVIEW_HH
+
+#include <string_view>
+#include <optional>
+#include "optionset.hh"
+#include "span.hh"
+
+namespace S6M
+{
+
+/*
+ * Read-only counterparts of the option sets, filled in by the same parsers.
+ * Variable-length fields point into the parsed buffer, which must outlive the view.
+ * Nothing is allocated.
+ */
+
+class OptionViewBase
+{
+protected:
+	typedef OptionSetBase::Mode Mode;
+
+	Mode mode;
+
+	bool permits(Mode mode1) const
+	{
+		return mode == mode1;
+	}
+
+	bool permits(Mode mode1, Mode mode2) const
+	{
+		return mode == mode1 || mode == mode2;
+	}
+
+	template <typename T>
+	static bool tryFill(std::optional<T> &field, T value)
+	{
+		if (field)
+			return false;
+		field = value;
+		return true;
+	}
+
+public:
+	OptionViewBase(Mode mode)
+		: mode(mode) {}
+};
+
+class SessionOptionView: public OptionViewBase
+{
+	enum Mandatory
+	{
+		NONE,
+		REQUEST,
+		ID,
+		OK,
+		INVALID,
+	};
+
+	Mandatory           mandatory = NONE;
+	Span<const uint8_t> id;
+
+	bool teardown  = false;
+	bool untrusted = false;
+
+	bool tryMandatory(Mandatory value)
+	{
+		if (mandatory != NONE)
+			return false;
+		mandatory = value;
+		return true;
+	}
+
+public:
+	using OptionViewBase::OptionViewBase;
+
+	bool tryRequest()
+	{
+		return permits(OptionSetBase::M_REQ) && tryMandatory(REQUEST);
+	}
+
+	bool requested() const
+	{
+		return mandatory == REQUEST;
+	}
+
+	bool tryTearDown()
+	{
+		if (!permits(OptionSetBase::M_REQ) || teardown)
+			return false;
+		teardown = true;
+		return true;
+	}
+
+	bool tornDown() const
+	{
+		return teardown;
+	}
+
+	bool trySetID(Span<const uint8_t> ticket)
+	{
+		if (!permits(OptionSetBase::M_REQ, OptionSetBase::M_AUTH_REP) || !tryMandatory(ID))
+			return false;
+		id = ticket;
+		return true;
+	}
+
+	/* empty if absent */
+	Span<const uint8_t> getID() const
+	{
+		return id;
+	}
+
+	bool trySignalOK()
+	{
+		return permits(OptionSetBase::M_AUTH_REP) && tryMandatory(OK);
+	}
+
+	bool isOK() const
+	{
+		return mandatory == OK;
+	}
+
+	bool trySignalReject()
+	{
+		return permits(OptionSetBase::M_AUTH_REP) && tryMandatory(INVALID);
+	}
+
+	bool rejected() const
+	{
+		return mandatory == INVALID;
+	}
+
+	bool trySetUntrusted()
+	{
+		if (!permits(OptionSetBase::M_REQ) || untrusted)
+			return false;
+		untrusted = true;
+		return true;
+	}
+
+	bool isUntrusted() const
+	{
+		return untrusted;
+	}
+};
+
+class IdempotenceOptionView: public OptionViewBase
+{
+	std::optional<uint32_t> requestSize;
+	std::optional<uint32_t> token;
+
+	std::optional<std::pair<uint32_t, uint32_t>> window;
+
+	std::optional<bool> reply;
+
+public:
+	using OptionViewBase::OptionViewBase;
+
+	bool tryRequest(uint32_t size)
+	{
+		return permits(OptionSetBase::M_REQ) && tryFill(requestSize, size);
+	}
+
+	uint32_t requestedSize() const
+	{
+		return requestSize.value_or(0);
+	}
+
+	bool trySetToken(uint32_t value)
+	{
+		return permits(OptionSetBase::M_REQ) && tryFill(token, value);
+	}
+
+	std::optional<uint32_t> getToken() const
+	{
+		return token;
+	}
+
+	bool tryAdvertise(std::pair<uint32_t, uint32_t> value)
+	{
+		return permits(OptionSetBase::M_AUTH_REP) && tryFill(window, value);
+	}
+
+	std::pair<uint32_t, uint32_t> getAdvertised() const
+	{
+		return window.value_or(std::pair<uint32_t, uint32_t>(0, 0));
+	}
+
+	bool trySetReply(bool accepted)
+	{
+		return permits(OptionSetBase::M_AUTH_REP) && tryFill(reply, accepted);
+	}
+
+	std::optional<bool> getReply() const
+	{
+		return reply;
+	}
+};
+
+template <typename OPT>
+class StackOptionPairView: public OptionViewBase
+{
+	typedef typename OPT::Value Value;
+
+	std::optional<Value> clientProxy;
+	std::optional<Value> proxyRemote;
+
+public:
+	typedef OPT Option;
+
+	using OptionViewBase::OptionViewBase;
+
+	bool trySet(SOCKS6StackLeg leg, Value value)
+	{
+		if (!permits(OptionSetBase::M_REQ, OptionSetBase::M_AUTH_REP))
+			return false;
+		switch (leg)
+		{
+		case SOCKS6_STACK_LEG_CLIENT_PROXY:
+			return tryFill(clientProxy, value);
+		case SOCKS6_STACK_LEG_PROXY_REMOTE:
+			return tryFill(proxyRemote, value);
+		case SOCKS6_STACK_LEG_BOTH:
+			if (clientProxy || proxyRemote)
+				return false;
+			clientProxy = value;
+			proxyRemote = value;
+			return true;
+		}
+		return false;
+	}
+
+	std::optional<Value> get(SOCKS6StackLeg leg) const
+	{
+		switch (leg)
+		{
+		case SOCKS6_STACK_LEG_CLIENT_PROXY:
+			return clientProxy;
+		case SOCKS6_STACK_LEG_PROXY_REMOTE:
+			return proxyRemote;
+		case SOCKS6_STACK_LEG_BOTH:
+			break;
+		}
+		return {};
+	}
+};
+
+struct StackOptionView: public OptionViewBase
+{
+	StackOptionPairView<TOSOption>     tos     { mode };
+	StackOptionPairView<TFOOption>     tfo     { mode };
+	StackOptionPairView<MPOption>      mp      { mode };
+	StackOptionPairView<BacklogOption> backlog { mode };
+
+	using OptionViewBase::OptionViewBase;
+};
+
+class UserPasswdOptionView: public OptionViewBase
+{
+	std::optional<std::pair<std::string_view, std::string_view>> creds;
+	std::optional<bool> reply;
+
+public:
+	using OptionViewBase::OptionViewBase;
+
+	bool trySetCredentials(const std::pair<std::string_view, std::string_view> &value)
+	{
+		return permits(OptionSetBase::M_REQ) && tryFill(creds, value);
+	}
+
+	std::pair<std::string_view, std::string_view> getCredentials() const
+	{
+		return creds.value_or(std::pair<std::string_view, std::string_view>());
+	}
+
+	bool trySetReply(bool success)
+	{
+		return permits(OptionSetBase::M_AUTH_REP) && tryFill(reply, success);
+	}
+
+	std::optional<bool> getReply() const
+	{
+		return reply;
+	}
+};
+
+class AuthMethodOptionView: public OptionViewBase
+{
+	bool                advertised = false;
+	Span<const uint8_t> methods;
+	uint16_t            initialDataLen = 0;
+
+	SOCKS6Method selected = SOCKS6_METHOD_NOAUTH;
+
+public:
+	using OptionViewBase::OptionViewBase;
+
+	bool tryAdvertise(Span<const uint8_t> value, uint16_t dataLen)
+	{
+		if (!permits(OptionSetBase::M_REQ) || advertised)
+			return false;
+		advertised     = true;
+		methods        = value;
+		initialDataLen = dataLen;
+		return true;
+	}
+
+	/* methods as they appear on the wire; may contain duplicates (see AuthMethodMask) */
+	Span<const uint8_t> getAdvertised() const
+	{
+		return methods;
+	}
+
+	uint16_t getInitialDataLen() const
+	{
+		return initialDataLen;
+	}
+
+	bool trySelect(SOCKS6Method method)
+	{
+		if (!permits(OptionSetBase::M_AUTH_REP) || selected != SOCKS6_METHOD_NOAUTH)
+			return false;
+		selected = method;
+		return true;
+	}
+
+	SOCKS6Method getSelected() const
+	{
+		return selected;
+	}
+};
+
+struct OptionSetView: public OptionViewBase
+{
+	StackOptionView       stack        { mode };
+	SessionOptionView     session      { mode };
+	IdempotenceOptionView idempotence  { mode };
+	UserPasswdOptionView  userPassword { mode };
+	AuthMethodOptionView  authMethods  { mode };
+
+	using OptionViewBase::OptionViewBase;
+
+	/* same rules as OptionSet::parse() */
+	template <typename BUFFER>
+	ParseResult parse(BUFFER *bb, uint16_t optionsLength) noexcept;
+
+	Mode getMode() const
+	{
+		return mode;
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_OPTIONSETVIEW_HH
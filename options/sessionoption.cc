@@ -1,14 +1,16 @@
 #include "sessionoption.hh"
 #include "optionset.hh"
+#include "optionsetview.hh"
 
 using namespace std;
 
 namespace S6M
 {
 
-void SessionRequestOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool SessionRequestOption::simpleParse(SET *optionSet)
 {
-	optionSet->session.request();
+	return optionSet->session.tryRequest();
 }
 
 void SessionIDOption::fill(uint8_t *buf) const
@@ -17,8 +19,7 @@ void SessionIDOption::fill(uint8_t *buf) const
 
 	SOCKS6SessionIDOption *opt = reinterpret_cast<SOCKS6SessionIDOption *>(buf);
 
-	for (int i = 0; i < (int)id.size(); i++)
-		opt->ticket[i] = id[i];
+	memcpy(opt->ticket, id.data(), id.size());
 }
 
 SessionIDOption::SessionIDOption(const SessionID &ticket)
@@ -35,36 +36,57 @@ SessionIDOption::SessionIDOption(const SessionID &ticket)
 
 size_t SessionIDOption::packedSize() const
 {
-	return sizeof(SOCKS6SessionIDOption) + id.size();
+	return sizeOf(id.size());
 }
 
-void SessionIDOption::incrementalParse(SOCKS6Option *buf, OptionSet *optionSet)
+template <typename SET>
+ParseResult SessionIDOption::incrementalParse(SOCKS6Option *buf, SET *optionSet)
 {
-	SOCKS6SessionIDOption *opt = rawOptCast<SOCKS6SessionIDOption>(buf);
+	SOCKS6SessionIDOption *opt = reinterpret_cast<SOCKS6SessionIDOption *>(buf);
 	
 	size_t idLen = ntohs(opt->optionHead.len) - sizeof(SOCKS6SessionIDOption);
-	SessionID id(opt->ticket, opt->ticket + idLen);
-	optionSet->session.setID(move(id));
+	/* length is a multiple of 4 and bounded by the options block */
+	if (idLen == 0)
+		return PR_INVALID;
+	
+	return optionSet->session.trySetID({ opt->ticket, idLen }) ? PR_SUCCESS : PR_INVALID;
 }
 
-void SessionTeardownOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool SessionTeardownOption::simpleParse(SET *optionSet)
 {
-	optionSet->session.tearDown();
+	return optionSet->session.tryTearDown();
 }
 
-void SessionOKOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool SessionOKOption::simpleParse(SET *optionSet)
 {
-	optionSet->session.signalOK();
+	return optionSet->session.trySignalOK();
 }
 
-void SessionInvalidOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool SessionInvalidOption::simpleParse(SET *optionSet)
 {
-	optionSet->session.signalReject();
+	return optionSet->session.trySignalReject();
 }
 
-void SessionUntrustedOption::simpleParse(OptionSet *optionSet)
+template <typename SET>
+bool SessionUntrustedOption::simpleParse(SET *optionSet)
 {
-	optionSet->session.setUntrusted();
+	return optionSet->session.trySetUntrusted();
 }
 
+template bool SessionRequestOption::simpleParse(OptionSet *optionSet);
+template ParseResult SessionIDOption::incrementalParse(SOCKS6Option *buf, OptionSet *optionSet);
+template bool SessionTeardownOption::simpleParse(OptionSet *optionSet);
+template bool SessionOKOption::simpleParse(OptionSet *optionSet);
+template bool SessionInvalidOption::simpleParse(OptionSet *optionSet);
+template bool SessionUntrustedOption::simpleParse(OptionSet *optionSet);
+template bool SessionRequestOption::simpleParse(OptionSetView *optionSet);
+template ParseResult SessionIDOption::incrementalParse(SOCKS6Option *buf, OptionSetView *optionSet);
+template bool SessionTeardownOption::simpleParse(OptionSetView *optionSet);
+template bool SessionOKOption::simpleParse(OptionSetView *optionSet);
+template bool SessionInvalidOption::simpleParse(OptionSetView *optionSet);
+template bool SessionUntrustedOption::simpleParse(OptionSetView *optionSet);
+
 }
@@ -2,6 +2,7 @@
 #define SOCKS6MSG_SESSIONOPTION_HH
 
 #include <vector>
+#include <memory_resource>
 #include <boost/container/small_vector.hpp>
 #include "option.hh"
 
@@ -11,12 +12,13 @@ namespace S6M
 static constexpr int SESSION_ID_PREALLOC = 32;
 
 using
-SessionID = boost::container::small_vector<uint8_t, SESSION_ID_PREALLOC>;
+SessionID = boost::container::small_vector<uint8_t, SESSION_ID_PREALLOC, std::pmr::polymorphic_allocator<uint8_t>>;
 
 class SessionRequestOption: public SimpleOptionBase<SessionRequestOption, SOCKS6_OPTION_SESSION_REQUEST>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 class SessionIDOption: public Option
@@ -27,6 +29,11 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 	
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_SESSION_ID;
+	static constexpr bool             PAYLOAD = true;
+	
+	typedef SOCKS6SessionIDOption RawOption;
+	
 	SessionIDOption(const SessionID &id);
 	
 	const SessionID *getID() const
@@ -36,31 +43,41 @@ public:
 	
 	virtual size_t packedSize() const;
 	
-	static void incrementalParse(SOCKS6Option *buf, OptionSet *optionSet);
+	static size_t sizeOf(size_t idLength)
+	{
+		return sizeof(SOCKS6SessionIDOption) + idLength;
+	}
+	
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *buf, SET *optionSet);
 };
 
 class SessionTeardownOption: public SimpleOptionBase<SessionTeardownOption, SOCKS6_OPTION_SESSION_TEARDOWN>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 class SessionOKOption: public SimpleOptionBase<SessionOKOption, SOCKS6_OPTION_SESSION_OK>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 class SessionInvalidOption: public SimpleOptionBase<SessionInvalidOption, SOCKS6_OPTION_SESSION_INVALID>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 class SessionUntrustedOption: public SimpleOptionBase<SessionUntrustedOption, SOCKS6_OPTION_SESSION_UNTRUSTED>
 {
 public:
-	static void simpleParse(OptionSet *optionSet);
+	template <typename SET>
+	static bool simpleParse(SET *optionSet);
 };
 
 }
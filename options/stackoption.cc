@@ -2,6 +2,7 @@
 #include "stackoption.hh"
 #include "sanity.hh"
 #include "optionset.hh"
+#include "optionsetview.hh"
 
 using namespace std;
 
@@ -19,75 +20,73 @@ void StackOption::fill(uint8_t *buf) const
 	opt->code  = getCode();
 }
 
-void StackOption::incrementalParse(SOCKS6Option *baseOpt, OptionSet *optionSet)
+/* indexed by level and code */
+template <typename SET>
+struct StackOptionTable
 {
-	SOCKS6StackOption *opt = rawOptCast<SOCKS6StackOption>(baseOpt);
+	static constexpr int LEVELS = SOCKS6_STACK_LEVEL_UDP + 1;
+	static constexpr int CODES  = SOCKS6_STACK_CODE_BACKLOG + 1;
 	
-	switch (opt->level)
+	OptionHandler<SET> handlers[LEVELS][CODES] = {};
+	
+	template <typename OPT>
+	constexpr void add()
+	{
+		handlers[OPT::LEVEL][OPT::CODE] = OptionHandler<SET>::template of<OPT>();
+	}
+	
+	constexpr StackOptionTable()
 	{
-	case SOCKS6_STACK_LEVEL_IP:
-		switch (opt->code)
-		{
-		case SOCKS6_STACK_CODE_TOS:
-			TOSOption::incrementalParse(opt, optionSet);
-			break;
-		default:
-			throw invalid_argument("Unknown code");
-		}
-		break;
-		
-	case SOCKS6_STACK_LEVEL_IPV4:
-		throw invalid_argument("Unknown code");
-		
-	case SOCKS6_STACK_LEVEL_IPV6:
-		throw invalid_argument("Unknown code");
-		
-	case SOCKS6_STACK_LEVEL_TCP:
-		switch (opt->code)
-		{
-		case SOCKS6_STACK_CODE_TFO:
-			TFOOption::incrementalParse(opt, optionSet);
-			break;
-			
-		case SOCKS6_STACK_CODE_MP:
-			MPOption::incrementalParse(opt, optionSet);
-			break;
-			
-		case SOCKS6_STACK_CODE_BACKLOG:
-			BacklogOption::incrementalParse(opt, optionSet);
-			break;
-			
-		default:
-			throw invalid_argument("Unknown code");
-		}
-		break;
-		
-	case SOCKS6_STACK_LEVEL_UDP:
-		throw invalid_argument("Unknown code");
-		
-	default:
-		throw invalid_argument("Bad stack level");
+		add<TOSOption>();
+		add<TFOOption>();
+		add<MPOption>();
+		add<BacklogOption>();
 	}
+};
+
+template <typename SET>
+static constexpr StackOptionTable<SET> STACK_OPTION_TABLE;
+
+template <typename SET>
+ParseResult StackOption::incrementalParse(SOCKS6Option *baseOpt, SET *optionSet)
+{
+	typedef StackOptionTable<SET> Table;
+	
+	SOCKS6StackOption *opt = reinterpret_cast<SOCKS6StackOption *>(baseOpt);
+	if (opt->level >= Table::LEVELS || opt->code >= Table::CODES)
+		return PR_INVALID;
+	
+	return STACK_OPTION_TABLE<SET>.handlers[opt->level][opt->code](baseOpt, optionSet);
 }
 
-void TOSOption::stackParse(RawOption *opt, OptionSet *optionSet)
+template <typename SET>
+bool TOSOption::stackParse(RawOption *opt, SET *optionSet)
 {
-	optionSet->stack.tos.set((SOCKS6StackLeg)opt->stackOptionHead.leg, opt->value);
+	return optionSet->stack.tos.trySet((SOCKS6StackLeg)opt->stackOptionHead.leg, opt->value);
 }
 
-void TFOOption::stackParse(RawOption *opt, OptionSet *optionSet)
+template <typename SET>
+bool TFOOption::stackParse(RawOption *opt, SET *optionSet)
 {
-	optionSet->stack.tfo.set((SOCKS6StackLeg)opt->stackOptionHead.leg, ntohs(opt->value));
+	return optionSet->stack.tfo.trySet((SOCKS6StackLeg)opt->stackOptionHead.leg, ntohs(opt->value));
 }
 
-void MPOption::stackParse(RawOption *opt, OptionSet *optionSet)
+template <typename SET>
+bool MPOption::stackParse(RawOption *opt, SET *optionSet)
 {
-	optionSet->stack.mp.set((SOCKS6StackLeg)opt->stackOptionHead.leg, opt->value);
+	if (!enumValid<SOCKS6MPAvailability>(opt->value))
+		return false;
+	
+	return optionSet->stack.mp.trySet((SOCKS6StackLeg)opt->stackOptionHead.leg, opt->value);
 }
 
-void BacklogOption::stackParse(RawOption *opt, OptionSet *optionSet)
+template <typename SET>
+bool BacklogOption::stackParse(RawOption *opt, SET *optionSet)
 {
-	optionSet->stack.backlog.set((SOCKS6StackLeg)opt->stackOptionHead.leg, ntohs(opt->value));
+	return optionSet->stack.backlog.trySet((SOCKS6StackLeg)opt->stackOptionHead.leg, ntohs(opt->value));
 }
 
+template ParseResult StackOption::incrementalParse(SOCKS6Option *baseOpt, OptionSet *optionSet);
+template ParseResult StackOption::incrementalParse(SOCKS6Option *baseOpt, OptionSetView *optionSet);
+
 }
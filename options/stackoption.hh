@@ -20,6 +20,11 @@ protected:
 	virtual void fill(uint8_t *buf) const;
 
 public:
+	static constexpr SOCKS6OptionKind KIND    = SOCKS6_OPTION_STACK;
+	static constexpr bool             PAYLOAD = true;
+	
+	typedef SOCKS6StackOption RawOption;
+	
 	SOCKS6StackLeg getLeg() const
 	{
 		return leg;
@@ -35,7 +40,8 @@ public:
 		return code;
 	}
 
-	static void incrementalParse(SOCKS6Option *baseOpt, OptionSet *optionSet);
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *baseOpt, SET *optionSet);
 
 	StackOption(SOCKS6StackLeg leg, SOCKS6StackLevel level, SOCKS6StackOptionCode code)
 		: Option(SOCKS6_OPTION_STACK), leg(leg), level(level), code(code) {}
@@ -46,7 +52,7 @@ class StackOptionBase: public StackOption
 {
 	V value;
 
-protected:
+public:
 	struct RawOption
 	{
 		SOCKS6StackOption stackOptionHead;
@@ -54,6 +60,7 @@ protected:
 		uint8_t           padding[paddingOf(sizeof(SOCKS6StackOption) + sizeof(RAW))];
 	} __attribute__((packed));
 
+protected:
 	virtual void fill(uint8_t *buf) const
 	{
 		StackOption::fill(buf);
@@ -66,6 +73,7 @@ public:
 	static constexpr SOCKS6StackLevel      LEVEL        = LVL;
 	static constexpr SOCKS6StackOptionCode CODE         = C;
 	static constexpr SOCKS6StackLeg        LEG_RESTRICT = LR;
+	static constexpr bool                  PAYLOAD      = false;
 	
 	typedef V Value;
 	
@@ -81,11 +89,18 @@ public:
 			throw std::invalid_argument("Bad leg");
 	}
 	
-	static void incrementalParse(SOCKS6StackOption *optBase, OptionSet *optionSet)
+	template <typename SET>
+	static ParseResult incrementalParse(SOCKS6Option *optBase, SET *optionSet)
 	{
-		RawOption *opt = rawOptCast<RawOption>(optBase, false);
+		RawOption *opt = reinterpret_cast<RawOption *>(optBase);
+		
+		int leg = opt->stackOptionHead.leg;
+		if (!enumValid<SOCKS6StackLeg>(leg))
+			return PR_INVALID;
+		if (LR != SOCKS6_STACK_LEG_BOTH && leg != LR)
+			return PR_INVALID;
 		
-		T::stackParse(opt, optionSet);
+		return T::stackParse(opt, optionSet) ? PR_SUCCESS : PR_INVALID;
 	}
 
 	V getValue() const
@@ -97,7 +112,8 @@ public:
 class TOSOption: public StackOptionBase<TOSOption, SOCKS6_STACK_LEVEL_IP, SOCKS6_STACK_CODE_TOS, uint8_t, uint8_t>
 {
 public:
-	static void stackParse(RawOption *opt, OptionSet *optionSet);
+	template <typename SET>
+	static bool stackParse(RawOption *opt, SET *optionSet);
 
 	using StackOptionBase::StackOptionBase;
 };
@@ -105,7 +121,8 @@ public:
 class TFOOption: public StackOptionBase<TFOOption, SOCKS6_STACK_LEVEL_TCP, SOCKS6_STACK_CODE_TFO, uint16_t, uint16_t, SOCKS6_STACK_LEG_PROXY_REMOTE>
 {
 public:
-	static void stackParse(RawOption *opt, OptionSet *optionSet);
+	template <typename SET>
+	static bool stackParse(RawOption *opt, SET *optionSet);
 
 	using StackOptionBase::StackOptionBase;
 };
@@ -113,7 +130,8 @@ public:
 class MPOption: public StackOptionBase<MPOption, SOCKS6_STACK_LEVEL_TCP, SOCKS6_STACK_CODE_MP, Enum<SOCKS6MPAvailability>, uint8_t, SOCKS6_STACK_LEG_PROXY_REMOTE>
 {
 public:
-	static void stackParse(RawOption *opt, OptionSet *optionSet);
+	template <typename SET>
+	static bool stackParse(RawOption *opt, SET *optionSet);
 
 	using StackOptionBase::StackOptionBase;
 };
@@ -121,7 +139,8 @@ public:
 class BacklogOption: public StackOptionBase<BacklogOption, SOCKS6_STACK_LEVEL_TCP, SOCKS6_STACK_CODE_BACKLOG, uint16_t, uint16_t, SOCKS6_STACK_LEG_PROXY_REMOTE>
 {
 public:
-	static void stackParse(RawOption *opt, OptionSet *optionSet);
+	template <typename SET>
+	static bool stackParse(RawOption *opt, SET *optionSet);
 
 	using StackOptionBase::StackOptionBase;
 };
@@ -0,0 +1,60 @@
+#include <arpa/inet.h>
+#include "vendoroption.hh"
+
+using namespace std;
+
+namespace S6M
+{
+
+namespace
+{
+
+struct VendorHandler
+{
+	VendorOption::Handler handler = nullptr;
+	void                 *context = nullptr;
+	size_t                size    = 0;
+	bool                  payload = false;
+};
+
+VendorHandler vendorHandlers[SOCKS6_OPTION_VENDOR_MAX - SOCKS6_OPTION_VENDOR_MIN + 1];
+
+}
+
+void VendorOption::registerHandler(uint16_t kind, Handler handler, void *context, size_t size, bool payload)
+{
+	if (kind < SOCKS6_OPTION_VENDOR_MIN)
+		throw invalid_argument("Not a vendor option");
+	if (handler == nullptr)
+		throw invalid_argument("No handler");
+	if (size < sizeof(SOCKS6Option) || size % SOCKS6_ALIGNMENT != 0)
+		throw invalid_argument("Bad option size");
+	
+	vendorHandlers[kind - SOCKS6_OPTION_VENDOR_MIN] = { handler, context, size, payload };
+}
+
+void VendorOption::unregisterHandler(uint16_t kind)
+{
+	if (kind < SOCKS6_OPTION_VENDOR_MIN)
+		throw invalid_argument("Not a vendor option");
+	
+	vendorHandlers[kind - SOCKS6_OPTION_VENDOR_MIN] = {};
+}
+
+ParseResult VendorOption::incrementalParse(SOCKS6Option *opt, OptionSetBase::Mode mode) noexcept
+{
+	uint16_t kind = ntohs(opt->kind);
+	size_t   len  = ntohs(opt->len);
+	if (kind < SOCKS6_OPTION_VENDOR_MIN)
+		return PR_INVALID;
+	
+	const VendorHandler &entry = vendorHandlers[kind - SOCKS6_OPTION_VENDOR_MIN];
+	if (!entry.handler || len < entry.size)
+		return PR_INVALID;
+	if (!entry.payload && len != entry.size)
+		return PR_INVALID;
+	
+	return entry.handler(opt, mode, entry.context) ? PR_SUCCESS : PR_INVALID;
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef SOCKS6MSG_VENDOROPTION_HH
+#define SOCKS6MSG_VENDOROPTION_HH
+
+#include "optionset.hh"
+
+namespace S6M
+{
+
+/*
+ * Hook for vendor-specific option kinds (SOCKS6_OPTION_VENDOR_MIN..SOCKS6_OPTION_VENDOR_MAX).
+ * Handlers are global and are not synchronized with parsing: register them at startup.
+ */
+class VendorOption
+{
+public:
+	/*
+	 * Gets the whole option, header included.
+	 * Its length has already been checked; returning false drops it.
+	 */
+	typedef bool (*Handler)(const SOCKS6Option *opt, OptionSetBase::Mode mode, void *context);
+	
+	/* size: smallest valid option; longer ones are dropped unless payload is set */
+	static void registerHandler(uint16_t kind, Handler handler, void *context = nullptr,
+		size_t size = sizeof(SOCKS6Option), bool payload = true);
+	
+	static void unregisterHandler(uint16_t kind);
+	
+	static ParseResult incrementalParse(SOCKS6Option *opt, OptionSetBase::Mode mode) noexcept;
+};
+
+}
+
+#endif // SOCKS6MSG_VENDOROPTION_HH
@@ -36,8 +36,8 @@ struct S6M_OptionSet
 {
 	struct
 	{
-		S6M_StackOption *options;
-		int             count;
+		struct S6M_StackOption *options;
+		int                    count;
 	} stack;
 	
 	struct
@@ -142,6 +142,50 @@ enum S6M_Error
 
 const char *S6M_Error_msg(enum S6M_Error err);
 
+/*
+ * Parse statistics: off until enabled, then counted per thread and added up by S6M_Stats_snapshot().
+ */
+enum S6M_StatsMessage
+{
+	S6M_STATS_REQUEST,
+	S6M_STATS_AUTH_REPLY,
+	S6M_STATS_OP_REPLY,
+	S6M_STATS_PASSWD_REQ,
+	S6M_STATS_PASSWD_REPLY,
+	S6M_STATS_DATAGRAM,
+	
+	S6M_STATS_MESSAGES,
+};
+
+/* why an option was left out of a parsed message */
+enum S6M_StatsDrop
+{
+	S6M_DROP_UNKNOWN,    /* unknown kind */
+	S6M_DROP_DUPLICATE,  /* kind already seen in the message */
+	S6M_DROP_TRUNCATED,  /* length too short or past the end of the options; the rest of the options go with it */
+	S6M_DROP_MISALIGNED, /* length not a multiple of 4; the rest of the options go with it */
+	S6M_DROP_REJECTED,   /* bad contents, or not allowed in this message */
+	S6M_DROP_EXCESS,     /* too many bad options; counted once for the rest of the options, which are skipped */
+	
+	S6M_STATS_DROPS,
+};
+
+/* indexed by -S6M_Error, from S6M_ERR_SUCCESS to S6M_ERR_ADDRTYPE */
+#define S6M_STATS_ERRORS 6
+/* option kinds up to SOCKS6_OPTION_IDEMPOTENCE_REJECT, then vendor options, then all other kinds */
+#define S6M_STATS_KINDS  (SOCKS6_OPTION_IDEMPOTENCE_REJECT + 3)
+
+struct S6M_Stats
+{
+	uint64_t messages[S6M_STATS_MESSAGES][S6M_STATS_ERRORS]; /* [type][0] counts messages parsed */
+	uint64_t errors[S6M_STATS_ERRORS];                       /* all types together */
+	uint64_t options[S6M_STATS_KINDS];                       /* options looked at */
+	uint64_t dropped[S6M_STATS_DROPS];
+};
+
+void S6M_Stats_enable(int enable);
+void S6M_Stats_snapshot(struct S6M_Stats *stats);
+
 ssize_t S6M_Request_pack    (const struct S6M_Request     *req,       uint8_t *buf, size_t size);
 ssize_t S6M_AuthReply_pack  (const struct S6M_AuthReply   *authReply, uint8_t *buf, size_t size);
 ssize_t S6M_OpReply_pack    (const struct S6M_OpReply     *opReply,   uint8_t *buf, size_t size);
@@ -154,12 +198,50 @@ ssize_t S6M_OpReply_packedSize    (const struct S6M_OpReply     *opReply);
 ssize_t S6M_PasswdReq_packedSize  (const struct S6M_PasswdReq   *pwReq);
 ssize_t S6M_PasswdReply_packedSize(const struct S6M_PasswdReply *pwReply);
 
+/*
+ * Packs the message if it fits in size bytes; returns its packed size either way.
+ * A result above size means nothing was written: retry with that much room (buf may be NULL if size is 0).
+ * Cheaper than calling *_packedSize() and *_pack(), which convert the message twice.
+ */
+ssize_t S6M_Request_packOrSize  (const struct S6M_Request   *req,       uint8_t *buf, size_t size);
+ssize_t S6M_AuthReply_packOrSize(const struct S6M_AuthReply *authReply, uint8_t *buf, size_t size);
+ssize_t S6M_OpReply_packOrSize  (const struct S6M_OpReply   *opReply,   uint8_t *buf, size_t size);
+
 ssize_t S6M_Request_parse    (uint8_t *buf, size_t size, struct S6M_Request     **preq);
 ssize_t S6M_AuthReply_parse  (uint8_t *buf, size_t size, struct S6M_AuthReply   **pauthReply);
 ssize_t S6M_OpReply_parse    (uint8_t *buf, size_t size, struct S6M_OpReply     **popReply);
 ssize_t S6M_PasswdReq_parse  (uint8_t *buf, size_t size, struct S6M_PasswdReq   **ppwReq);
 ssize_t S6M_PasswdReply_parse(uint8_t *buf, size_t size, struct S6M_PasswdReply **ppwReply);
 
+/*
+ * Size of the message starting at buf, as far as the first size bytes tell.
+ * If the result exceeds size, call again once that many bytes are available.
+ * Otherwise, the whole message is in and can be parsed.
+ */
+ssize_t S6M_Request_peekSize  (uint8_t *buf, size_t size);
+ssize_t S6M_AuthReply_peekSize(uint8_t *buf, size_t size);
+ssize_t S6M_OpReply_peekSize  (uint8_t *buf, size_t size);
+
+/*
+ * Caller-provided room for the *_parseInto() functions. Allocate it however you like (stack, slab, ...).
+ * It holds the strings and arrays a parsed message points to; the session ID points into the parsed buffer instead.
+ * Nothing is allocated, so there is nothing to free; reusing the storage invalidates the previous message.
+ */
+#define S6M_PARSE_STORAGE_SIZE 2048
+
+struct S6M_ParseStorage
+{
+	union
+	{
+		uint8_t  bytes[S6M_PARSE_STORAGE_SIZE];
+		uint64_t align;
+	} priv;
+};
+
+ssize_t S6M_Request_parseInto  (uint8_t *buf, size_t size, struct S6M_Request   *req,       struct S6M_ParseStorage *storage);
+ssize_t S6M_AuthReply_parseInto(uint8_t *buf, size_t size, struct S6M_AuthReply *authReply, struct S6M_ParseStorage *storage);
+ssize_t S6M_OpReply_parseInto  (uint8_t *buf, size_t size, struct S6M_OpReply   *opReply,   struct S6M_ParseStorage *storage);
+
 void S6M_Request_free    (struct S6M_Request     *req);
 void S6M_AuthReply_free  (struct S6M_AuthReply   *authReply);
 void S6M_OpReply_free    (struct S6M_OpReply     *opReply);
@@ -6,6 +6,11 @@
 #include "authreply.hh"
 #include "opreply.hh"
 #include "usrpasswd.hh"
+#include "requestview.hh"
+#include "authreplyview.hh"
+#include "opreplyview.hh"
+#include "streamparser.hh"
+#include "vendoroption.hh"
 #include "exceptions.hh"
 
 #endif // SOCKS6MSG_HH
@@ -7,6 +7,9 @@ CONFIG -= qt
 
 INCLUDEPATH += fields messages options util
 
+# static probes for bpftrace/perf (qmake CONFIG+=tracepoints); needs <sys/sdt.h>
+tracepoints: DEFINES += SOCKS6MSG_TRACEPOINTS
+
 SOURCES += \
     options/option.cc \
     options/stackoption.cc \
@@ -16,7 +19,11 @@ SOURCES += \
     options/optionset.cc \
     fields/address.cc \
     cbindings.cc \
-    options/sessionoption.cc
+    options/sessionoption.cc \
+    options/vendoroption.cc \
+    messages/datagrambatch.cc \
+    messages/prepackedmessage.cc \
+    util/parsestats.cc
 
 HEADERS += \
     fields/versionchecker.hh \
@@ -42,9 +49,29 @@ HEADERS += \
     options/sessionoption.hh \
     util/byteorder.hh \
     util/exceptions.hh \
+    util/parseresult.hh \
     fields/padded.hh \
     util/restrictedint.hh \
-    messages/datagramheader.hh
+    messages/datagramheader.hh \
+    messages/streamparser.hh \
+    messages/requestview.hh \
+    messages/authreplyview.hh \
+    messages/opreplyview.hh \
+    options/optionsetview.hh \
+    options/vendoroption.hh \
+    util/span.hh \
+    fields/authmethodmask.hh \
+    messages/datagrambatch.hh \
+    messages/datagramprefix.hh \
+    messages/prepackedmessage.hh \
+    util/associationtable.hh \
+    util/gatherbuffer.hh \
+    util/scatterbuffer.hh \
+    util/parsestats.hh \
+    util/tracepoints.hh \
+    util/idempotencewindow.hh \
+    util/tokenallocator.hh \
+    util/sessiontable.hh
 
 unix {
     headers.path = /usr/local/include/socks6msg
@@ -0,0 +1,308 @@
+#ifndef SOCKS6MSG_ASSOCIATIONTABLE_HH
+#define SOCKS6MSG_ASSOCIATIONTABLE_HH
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+
+namespace S6M
+{
+
+/*
+ * Association IDs that do not repeat: a counter run through a keyed bijective mix.
+ * They are hard to guess by accident, not by an attacker; check the source address too.
+ * Never hands out the IDs AssociationTable reserves.
+ */
+class AssociationIDGenerator
+{
+	uint64_t key;
+	std::atomic<uint64_t> counter { 0 };
+
+	static uint64_t mix(uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111eb;
+		x ^= x >> 31;
+		return x;
+	}
+
+public:
+	AssociationIDGenerator()
+		: key(((uint64_t)std::random_device()() << 32) | std::random_device()()) {}
+
+	explicit AssociationIDGenerator(uint64_t key)
+		: key(key) {}
+
+	uint64_t next()
+	{
+		uint64_t id;
+		do
+		{
+			id = mix(counter.fetch_add(1, std::memory_order_relaxed) + key);
+		}
+		while (id == 0 || id == UINT64_MAX);
+		return id;
+	}
+};
+
+/**
+ * @brief Maps association IDs to association state
+ * Open addressing over cache-line buckets, sized once for a maximum number of associations.
+ * Lookups take no lock and can run alongside each other and alongside a writer;
+ * inserts and erases are serialized internally.
+ * Stores T *; IDs 0 and UINT64_MAX are reserved.
+ */
+template <typename T>
+class AssociationTable
+{
+	static constexpr uint64_t EMPTY     = 0;
+	static constexpr uint64_t TOMBSTONE = UINT64_MAX;
+
+	static constexpr int SLOTS = 7;
+
+	/*
+	 * IDs only, so that probes rarely spill into the next bucket; the value is only fetched on a hit.
+	 * seq is a seqlock over the bucket and its values: odd while a writer is in.
+	 */
+	struct alignas(64) Bucket
+	{
+		std::atomic<uint32_t> seq { 0 };
+		std::atomic<uint64_t> ids[SLOTS] = {};
+	};
+	static_assert(sizeof(Bucket) == 64, "Bucket should fill one cache line");
+
+	size_t bucketCount;
+	std::unique_ptr<Bucket[]> buckets;
+	/* SLOTS per bucket */
+	std::unique_ptr<std::atomic<T *>[]> values;
+
+	std::mutex writeLock;
+	std::atomic<size_t> count { 0 };
+	/* live entries and tombstones */
+	size_t used = 0;
+
+	size_t home(uint64_t id) const
+	{
+		/* IDs might not come from AssociationIDGenerator; spread them anyway */
+		uint64_t hash = id * 0x9e3779b97f4a7c15;
+		return ((unsigned __int128)hash * bucketCount) >> 64;
+	}
+
+	size_t nextBucket(size_t bucket) const
+	{
+		return bucket + 1 == bucketCount ? 0 : bucket + 1;
+	}
+
+	std::atomic<T *> *valueOf(size_t bucket, int slot) const
+	{
+		return &values[bucket * SLOTS + slot];
+	}
+
+	/* *done once the probe has reached a bucket with an empty slot */
+	bool probe(size_t bucket, uint64_t id, T **value, bool *done) const
+	{
+		const Bucket *b = &buckets[bucket];
+		for (;;)
+		{
+			uint32_t seq = b->seq.load(std::memory_order_acquire);
+			if (seq & 1)
+				continue;
+
+			/* no early exit: which slot a hit lands in is random, so branching on it mispredicts */
+			bool found = false;
+			bool empty = false;
+			int match = 0;
+			for (int slot = 0; slot < SLOTS; slot++)
+			{
+				uint64_t slotID = b->ids[slot].load(std::memory_order_relaxed);
+				match  = slotID == id ? slot : match;
+				found |= slotID == id;
+				empty |= slotID == EMPTY;
+			}
+			if (found)
+				*value = valueOf(bucket, match)->load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (b->seq.load(std::memory_order_relaxed) != seq)
+				continue;
+
+			*done = found || empty;
+			return found;
+		}
+	}
+
+	void write(size_t bucket, int slot, uint64_t id, T *value)
+	{
+		Bucket *b = &buckets[bucket];
+		uint32_t seq = b->seq.load(std::memory_order_relaxed);
+		b->seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		b->ids[slot].store(id, std::memory_order_relaxed);
+		valueOf(bucket, slot)->store(value, std::memory_order_relaxed);
+
+		b->seq.store(seq + 2, std::memory_order_release);
+	}
+
+public:
+	/* room for maxAssociations, with some slack so probes stay short */
+	explicit AssociationTable(size_t maxAssociations)
+		: bucketCount(maxAssociations * 5 / (SLOTS * 4) + 1),
+		  buckets(new Bucket[bucketCount]),
+		  values(new std::atomic<T *>[bucketCount * SLOTS]()) {}
+
+	AssociationTable(const AssociationTable &) = delete;
+	AssociationTable &operator =(const AssociationTable &) = delete;
+
+	T *find(uint64_t id) const
+	{
+		size_t bucket = home(id);
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			T *value;
+			bool done;
+			if (probe(bucket, id, &value, &done))
+				return value;
+			if (done)
+				return nullptr;
+			bucket = nextBucket(bucket);
+		}
+		return nullptr;
+	}
+
+	/* e.g. over DatagramBatch::assocID; associations[i] is nullptr for unknown IDs */
+	void find(const uint64_t *ids, size_t idCount, T **associations) const
+	{
+		/* the buckets and their values come in while the earlier ones are probed */
+		for (size_t i = 0; i < idCount; i++)
+		{
+			size_t bucket = home(ids[i]);
+			__builtin_prefetch(&buckets[bucket]);
+			__builtin_prefetch(valueOf(bucket, 0));
+		}
+		for (size_t i = 0; i < idCount; i++)
+			associations[i] = find(ids[i]);
+	}
+
+	/* false if the ID is taken or the table is full */
+	bool insert(uint64_t id, T *association)
+	{
+		if (id == EMPTY || id == TOMBSTONE)
+			return false;
+
+		std::lock_guard<std::mutex> guard(writeLock);
+
+		/* first free slot along the probe */
+		size_t target = bucketCount;
+		int targetSlot = 0;
+		bool targetEmpty = false;
+
+		size_t bucket = home(id);
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			Bucket *b = &buckets[bucket];
+			bool empty = false;
+			for (int slot = 0; slot < SLOTS; slot++)
+			{
+				uint64_t slotID = b->ids[slot].load(std::memory_order_relaxed);
+				if (slotID == id)
+					return false;
+				if ((slotID == TOMBSTONE || slotID == EMPTY) && target == bucketCount)
+				{
+					target = bucket;
+					targetSlot = slot;
+					targetEmpty = slotID == EMPTY;
+				}
+				empty |= slotID == EMPTY;
+			}
+			/* nothing with this ID got past a bucket with room */
+			if (empty)
+				break;
+			bucket = nextBucket(bucket);
+		}
+
+		if (target == bucketCount)
+			return false;
+		if (targetEmpty)
+		{
+			/* keep one empty slot around, so probes always end */
+			if (used + 1 >= bucketCount * SLOTS)
+				return false;
+			used++;
+		}
+		write(target, targetSlot, id, association);
+		count.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/* inserts under a fresh ID; returns 0 if the table is (nearly) full */
+	uint64_t add(AssociationIDGenerator *generator, T *association)
+	{
+		for (int attempt = 0; attempt < 8; attempt++)
+		{
+			uint64_t id = generator->next();
+			if (insert(id, association))
+				return id;
+		}
+		return 0;
+	}
+
+	/* returns what was stored, or nullptr */
+	T *erase(uint64_t id)
+	{
+		if (id == EMPTY || id == TOMBSTONE)
+			return nullptr;
+
+		std::lock_guard<std::mutex> guard(writeLock);
+
+		size_t bucket = home(id);
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			Bucket *b = &buckets[bucket];
+			int match = -1;
+			bool empty = false;
+			for (int slot = 0; slot < SLOTS; slot++)
+			{
+				uint64_t slotID = b->ids[slot].load(std::memory_order_relaxed);
+				if (slotID == id)
+					match = slot;
+				empty |= slotID == EMPTY;
+			}
+
+			if (match >= 0)
+			{
+				T *association = valueOf(bucket, match)->load(std::memory_order_relaxed);
+				/* a bucket with room ends every probe that reaches it, so the slot can be freed outright */
+				if (empty)
+				{
+					write(bucket, match, EMPTY, nullptr);
+					used--;
+				}
+				else
+				{
+					write(bucket, match, TOMBSTONE, nullptr);
+				}
+				count.fetch_sub(1, std::memory_order_relaxed);
+				return association;
+			}
+			if (empty)
+				return nullptr;
+			bucket = nextBucket(bucket);
+		}
+		return nullptr;
+	}
+
+	size_t size() const
+	{
+		return count.load(std::memory_order_relaxed);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_ASSOCIATIONTABLE_HH
@@ -2,6 +2,7 @@
 #define SOCKS6MSG_BYTEBUFFER_HH
 
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>
 #include "exceptions.hh"
 
@@ -36,15 +37,42 @@ public:
 		return totalSize;
 	}
 	
+	ByteBuffer &operator =(const ByteBuffer &other) = default;
+	
+	/* non-throwing variants: return nullptr instead of throwing EndOfBufferException */
 	template <typename T>
-	T *peek(size_t count = 1)
+	T *tryPeek(size_t count = 1) const noexcept
 	{
 		size_t req = sizeof(T) * count;
 
 		if (req + used > totalSize)
-			throw EndOfBufferException();
+			return nullptr;
+
+		return reinterpret_cast<T *>(buf + used);
+	}
 
-		T *ret = reinterpret_cast<T *>(buf + used);
+	template <typename T>
+	T *tryGet(size_t count = 1) noexcept
+	{
+		T *ret = tryPeek<T>(count);
+		if (ret)
+			used += sizeof(T) * count;
+		return ret;
+	}
+	
+	bool trySkip(size_t count) noexcept
+	{
+		return tryGet<uint8_t>(count) != nullptr;
+	}
+	
+	template <typename T>
+	T *peek(size_t count = 1)
+	{
+		T *ret = tryPeek<T>(count);
+		
+		if (!ret)
+			throw EndOfBufferException();
+		
 		return ret;
 	}
 
@@ -0,0 +1,80 @@
+#ifndef SOCKS6MSG_GATHERBUFFER_HH
+#define SOCKS6MSG_GATHERBUFFER_HH
+
+#include <string.h>
+#include <sys/uio.h>
+#include "bytebuffer.hh"
+
+namespace S6M
+{
+
+/*
+ * Packs into an iovec list for writev()/sendmsg().
+ * Fixed-size fields go into a scratch buffer, through the ByteBuffer interface.
+ * Large fields (session IDs, credentials, domains) are referenced where they live, so the message must outlive the iovecs.
+ */
+class GatherBuffer: public ByteBuffer
+{
+	iovec  *iovs;
+	size_t iovCapacity;
+	size_t iovCount = 0;
+
+	/* scratch bytes not yet covered by an iovec start here */
+	size_t segmentStart = 0;
+	size_t referenced = 0;
+
+	void push(void *base, size_t len)
+	{
+		if (len > 0)
+			iovs[iovCount++] = { base, len };
+	}
+
+public:
+	/* smaller fields are cheaper to copy than to give an iovec of their own */
+	static constexpr size_t REFERENCE_MIN = 64;
+
+	GatherBuffer(uint8_t *scratch, size_t scratchSize, iovec *iovs, size_t iovCapacity)
+		: ByteBuffer(scratch, scratchSize), iovs(iovs), iovCapacity(iovCapacity) {}
+
+	/* copies data to the scratch buffer if it is small or if iovecs are running out */
+	void append(const uint8_t *data, size_t size)
+	{
+		/* the scratch segment so far, this field and whatever scratch comes after */
+		if (size < REFERENCE_MIN || iovCount + 3 > iovCapacity)
+		{
+			put(data, size);
+			return;
+		}
+
+		push(getBuf() + segmentStart, getUsed() - segmentStart);
+		push(const_cast<uint8_t *>(data), size);
+		segmentStart = getUsed();
+		referenced += size;
+	}
+
+	/* covers the rest of the scratch buffer; returns how many iovecs were used */
+	size_t finish()
+	{
+		if (iovCount == iovCapacity && getUsed() > segmentStart)
+			throw EndOfBufferException();
+
+		push(getBuf() + segmentStart, getUsed() - segmentStart);
+		segmentStart = getUsed();
+		return iovCount;
+	}
+
+	const iovec *getIOVecs() const
+	{
+		return iovs;
+	}
+
+	/* scratch and referenced bytes alike */
+	size_t getTotalSize() const
+	{
+		return getUsed() + referenced;
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_GATHERBUFFER_HH
@@ -0,0 +1,194 @@
+#ifndef SOCKS6MSG_IDEMPOTENCEWINDOW_HH
+#define SOCKS6MSG_IDEMPOTENCEWINDOW_HH
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "socks6.h"
+
+namespace S6M
+{
+
+/**
+ * @brief Spent-token bookkeeping for one session's idempotence window
+ * Tokens live in [base, base + size), modulo 2^32; each can be spent once.
+ * The bitmap is a ring indexed by token, so sliding the window moves no bits:
+ * each 32-token word is tagged with the tokens it stands for, and stale words are reset by whoever spends in them next.
+ * Spending takes no lock and can race with other spends and with slides.
+ */
+class IdempotenceWindow
+{
+	/* high half: first token of the word; low half: spent bits */
+	typedef std::atomic<uint64_t> Word;
+
+	static constexpr uint32_t WORD_TOKENS = 32;
+
+	static uint32_t tagOf(uint32_t token)
+	{
+		return token & ~(WORD_TOKENS - 1);
+	}
+
+	struct Free
+	{
+		void operator ()(Word *words) const
+		{
+			free(words);
+		}
+	};
+
+	size_t wordMask;
+	/* zeroed pages cost nothing until touched; all-zero words are a valid, empty state */
+	std::unique_ptr<Word[], Free> words;
+
+	/* high half: base; low half: size; read together */
+	std::atomic<uint64_t> window;
+
+	static size_t wordsFor(uint32_t capacity)
+	{
+		/* one word of slack, as the window need not start at a word boundary */
+		size_t count = 1;
+		while (count * WORD_TOKENS < (size_t)capacity + WORD_TOKENS)
+			count <<= 1;
+		return count;
+	}
+
+public:
+	/* capacity bounds the size of later windows, and sets the memory use: capacity / 8 bytes or so */
+	IdempotenceWindow(std::pair<uint32_t, uint32_t> initial, uint32_t capacity = 0)
+		: wordMask(wordsFor(std::max(initial.second, capacity)) - 1),
+		  words(static_cast<Word *>(calloc(wordMask + 1, sizeof(Word)))),
+		  window(((uint64_t)initial.first << 32) | initial.second)
+	{
+		if (initial.second < SOCKS6_TOKEN_WINDOW_MIN || initial.second > SOCKS6_TOKEN_WINDOW_MAX)
+			throw std::invalid_argument("Bad window size");
+		if (!words)
+			throw std::bad_alloc();
+	}
+
+	std::pair<uint32_t, uint32_t> getWindow() const
+	{
+		uint64_t w = window.load(std::memory_order_acquire);
+		return { (uint32_t)(w >> 32), (uint32_t)w };
+	}
+
+	/* false if the token is outside the window or already spent */
+	bool spend(uint32_t token)
+	{
+		Word *word = &words[(token / WORD_TOKENS) & wordMask];
+		uint32_t tag = tagOf(token);
+		uint32_t bit = 1U << (token % WORD_TOKENS);
+
+		uint64_t old = word->load(std::memory_order_acquire);
+		for (;;)
+		{
+			/* re-read on every attempt: a slide may have raced with the last one */
+			std::pair<uint32_t, uint32_t> w = getWindow();
+			if ((uint32_t)(token - w.first) >= w.second)
+				return false;
+
+			uint32_t oldTag = old >> 32;
+			uint32_t oldBits = old;
+			uint64_t desired;
+			if (oldTag == tag)
+			{
+				if (oldBits & bit)
+					return false;
+				desired = old | bit;
+			}
+			else if (oldBits == 0 || (uint32_t)(oldTag - tagOf(w.first)) >= w.second + WORD_TOKENS)
+			{
+				/* untouched, or left over from a lap the window has moved past */
+				desired = ((uint64_t)tag << 32) | bit;
+			}
+			else
+			{
+				/* taken by a later lap: the window has slid past the token */
+				return false;
+			}
+
+			if (word->compare_exchange_weak(old, desired, std::memory_order_acq_rel, std::memory_order_acquire))
+				return true;
+		}
+	}
+
+	bool isSpent(uint32_t token) const
+	{
+		uint64_t w = words[(token / WORD_TOKENS) & wordMask].load(std::memory_order_acquire);
+		return (w >> 32) == tagOf(token) && (w & (1ULL << (token % WORD_TOKENS)));
+	}
+
+	/*
+	 * Moves the window forward (or resizes it) in O(1); tokens left behind can no longer be spent.
+	 * Fails if the window would go backwards or outgrow the capacity.
+	 */
+	bool slide(std::pair<uint32_t, uint32_t> next)
+	{
+		if (next.second < SOCKS6_TOKEN_WINDOW_MIN || next.second > SOCKS6_TOKEN_WINDOW_MAX)
+			return false;
+		if ((size_t)next.second + WORD_TOKENS > (wordMask + 1) * WORD_TOKENS)
+			return false;
+
+		uint64_t current = window.load(std::memory_order_relaxed);
+		do
+		{
+			if ((int32_t)(next.first - (uint32_t)(current >> 32)) < 0)
+				return false;
+		}
+		while (!window.compare_exchange_weak(current, ((uint64_t)next.first << 32) | next.second, std::memory_order_acq_rel, std::memory_order_relaxed));
+		return true;
+	}
+};
+
+/**
+ * @brief Idempotence windows keyed by session ID
+ * Lookups hand out shared ownership, so that spending needs no lock on the table.
+ */
+class IdempotenceTracker
+{
+	std::mutex lock;
+	std::unordered_map<std::string, std::shared_ptr<IdempotenceWindow>> windows;
+
+public:
+	/* replaces whatever window the session had */
+	std::shared_ptr<IdempotenceWindow> open(std::string_view sessionID, std::pair<uint32_t, uint32_t> window, uint32_t capacity = 0)
+	{
+		std::shared_ptr<IdempotenceWindow> created = std::make_shared<IdempotenceWindow>(window, capacity);
+
+		std::lock_guard<std::mutex> guard(lock);
+		windows[std::string(sessionID)] = created;
+		return created;
+	}
+
+	std::shared_ptr<IdempotenceWindow> find(std::string_view sessionID)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = windows.find(std::string(sessionID));
+		if (it == windows.end())
+			return nullptr;
+		return it->second;
+	}
+
+	void close(std::string_view sessionID)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		windows.erase(std::string(sessionID));
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return windows.size();
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_IDEMPOTENCEWINDOW_HH
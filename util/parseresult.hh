@@ -0,0 +1,57 @@
+#ifndef SOCKS6MSG_PARSERESULT_HH
+#define SOCKS6MSG_PARSERESULT_HH
+
+#include <new>
+#include <stdexcept>
+#include "bytebuffer.hh"
+#include "exceptions.hh"
+
+namespace S6M
+{
+
+/**
+ * @brief The ParseResult enum
+ * Outcome of the non-throwing parse functions.
+ * Mirrors the categories of S6M_Error.
+ */
+enum ParseResult
+{
+	PR_SUCCESS,
+	PR_INVALID,  /* some invalid field */
+	PR_ALLOC,    /* allocation failure */
+	PR_BUFFER,   /* reached end of buffer */
+	PR_OTHERVER, /* protocol version other than the one supported */
+	PR_ADDRTYPE, /* bad address type */
+};
+
+/*
+ * Turns a failed ParseResult into the exception the throwing parsers used to raise.
+ * bb must be the buffer handed to the failed parse; parse functions leave it untouched on failure.
+ */
+inline void enforceParseResult(ParseResult result, ByteBuffer *bb)
+{
+	switch (result)
+	{
+	case PR_SUCCESS:
+		return;
+
+	case PR_INVALID:
+		throw std::invalid_argument("Invalid field");
+
+	case PR_ALLOC:
+		throw std::bad_alloc();
+
+	case PR_BUFFER:
+		throw EndOfBufferException();
+
+	case PR_OTHERVER:
+		throw BadVersionException(*bb->peek<uint8_t>());
+
+	case PR_ADDRTYPE:
+		throw BadAddressTypeException();
+	}
+}
+
+}
+
+#endif // SOCKS6MSG_PARSERESULT_HH
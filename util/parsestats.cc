@@ -0,0 +1,67 @@
+#include <mutex>
+#include "parsestats.hh"
+
+using namespace std;
+
+namespace S6M
+{
+
+atomic<bool> ParseStats::enabled { false };
+
+/* guards the list of live blocks, and what the dead ones had counted */
+static mutex statsLock;
+static ParseStats::Totals retired;
+
+ParseStats::Counters *ParseStats::liveHead = nullptr;
+
+ParseStats::Counters::Counters()
+{
+	lock_guard<mutex> guard(statsLock);
+	next = liveHead;
+	if (next)
+		next->prev = this;
+	liveHead = this;
+}
+
+ParseStats::Counters::~Counters()
+{
+	lock_guard<mutex> guard(statsLock);
+	addTo(&retired);
+	if (prev)
+		prev->next = next;
+	else
+		liveHead = next;
+	if (next)
+		next->prev = prev;
+}
+
+void ParseStats::Counters::addTo(Totals *totals) const
+{
+	for (int i = 0; i < MESSAGES; i++)
+	{
+		for (int j = 0; j < RESULTS; j++)
+			totals->messages[i][j] += messages[i][j].load(memory_order_relaxed);
+	}
+	for (int i = 0; i < KIND_SLOTS; i++)
+		totals->options[i] += options[i].load(memory_order_relaxed);
+	for (int i = 0; i < DROPS; i++)
+		totals->drops[i] += drops[i].load(memory_order_relaxed);
+}
+
+ParseStats::Counters *ParseStats::local() noexcept
+{
+	/* registered on first use, so threads that never count cost nothing */
+	thread_local Counters counters;
+	return &counters;
+}
+
+ParseStats::Totals ParseStats::snapshot()
+{
+	lock_guard<mutex> guard(statsLock);
+	Totals totals = retired;
+	for (Counters *counters = liveHead; counters; counters = counters->next)
+		counters->addTo(&totals);
+	return totals;
+}
+
+}
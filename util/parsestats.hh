@@ -0,0 +1,134 @@
+#ifndef SOCKS6MSG_PARSESTATS_HH
+#define SOCKS6MSG_PARSESTATS_HH
+
+#include <stdint.h>
+#include <atomic>
+#include "socks6.h"
+#include "parseresult.hh"
+
+namespace S6M
+{
+
+/**
+ * @brief Parse-time counters
+ * Off by default; once enabled, each thread counts into its own block, and snapshot() adds the blocks up.
+ * Threads that have exited still count towards the totals.
+ */
+class ParseStats
+{
+public:
+	enum Message
+	{
+		REQUEST,
+		AUTH_REPLY,
+		OP_REPLY,
+		PASSWD_REQ,
+		PASSWD_REPLY,
+		DATAGRAM,
+
+		MESSAGES,
+	};
+
+	/* why an option was left out of the option set */
+	enum Drop
+	{
+		DROP_UNKNOWN,    /* kind not known at all */
+		DROP_DUPLICATE,  /* kind already seen in the same message, and not taken twice */
+		DROP_TRUNCATED,  /* length too short, or past the end of the options */
+		DROP_MISALIGNED, /* length not a multiple of SOCKS6_ALIGNMENT */
+		DROP_REJECTED,   /* bad contents, or not allowed in this message */
+		DROP_EXCESS,     /* too many options were dropped already; once for the rest of the block */
+
+		DROPS,
+	};
+
+	/* kinds up to SOCKS6_OPTION_IDEMPOTENCE_REJECT, then vendor options, then everything else */
+	static constexpr int KINDS = SOCKS6_OPTION_IDEMPOTENCE_REJECT + 1;
+	static constexpr int KIND_VENDOR = KINDS;
+	static constexpr int KIND_OTHER = KINDS + 1;
+	static constexpr int KIND_SLOTS = KINDS + 2;
+
+	/* indexed by ParseResult; PR_SUCCESS counts messages parsed */
+	static constexpr int RESULTS = PR_ADDRTYPE + 1;
+
+	struct Totals
+	{
+		uint64_t messages[MESSAGES][RESULTS] = {};
+		uint64_t options[KIND_SLOTS] = {};
+		uint64_t drops[DROPS] = {};
+	};
+
+	static void enable(bool on) noexcept
+	{
+		enabled.store(on, std::memory_order_relaxed);
+	}
+
+	static bool isEnabled() noexcept
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	/* passes result through, so that parsers can count on their way out */
+	static ParseResult message(Message type, ParseResult result) noexcept
+	{
+		if (isEnabled())
+			bump(&local()->messages[type][result]);
+		return result;
+	}
+
+	static void option(uint16_t kind) noexcept
+	{
+		if (isEnabled())
+			bump(&local()->options[kindSlot(kind)]);
+	}
+
+	static void drop(Drop reason) noexcept
+	{
+		if (isEnabled())
+			bump(&local()->drops[reason]);
+	}
+
+	static Totals snapshot();
+
+private:
+	/* linked into a global list for as long as the thread is alive */
+	struct Counters
+	{
+		std::atomic<uint64_t> messages[MESSAGES][RESULTS] = {};
+		std::atomic<uint64_t> options[KIND_SLOTS] = {};
+		std::atomic<uint64_t> drops[DROPS] = {};
+
+		Counters *prev = nullptr;
+		Counters *next = nullptr;
+
+		Counters();
+		~Counters();
+
+		void addTo(Totals *totals) const;
+	};
+
+	static std::atomic<bool> enabled;
+	static Counters *liveHead;
+
+	/* the calling thread's block */
+	static Counters *local() noexcept;
+
+	static int kindSlot(uint16_t kind) noexcept
+	{
+		if (kind < KINDS)
+			return kind;
+		if (kind >= SOCKS6_OPTION_VENDOR_MIN)
+			return KIND_VENDOR;
+		return KIND_OTHER;
+	}
+
+	/* only the owning thread writes; snapshot() may read at any time */
+	static void bump(std::atomic<uint64_t> *counter) noexcept
+	{
+		counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_PARSESTATS_HH
@@ -22,10 +22,15 @@ public:
 	BoundedInt(T value)
 		: value(value)
 	{
-		if (value < MIN || value > MAX)
+		if (!inBounds(value))
 			throw std::range_error("Value out of bounds");
 	}
 	
+	static bool inBounds(T value)
+	{
+		return value >= MIN && value <= MAX;
+	}
+	
 	operator T () const
 	{
 		return value;
@@ -11,56 +11,81 @@ namespace S6M
 {
 
 template <typename ENUM>
-inline ENUM enumCast(int val)
+inline bool enumValid(int val)
 {
 	/* fail if instantiated */
 	switch ((ENUM)val) {}
 }
 
 template <>
-inline SOCKS6StackLeg enumCast<SOCKS6StackLeg>(int val)
+inline bool enumValid<SOCKS6StackLeg>(int val)
 {
-	SOCKS6StackLeg conv = (SOCKS6StackLeg)val;
-
-	switch (conv)
+	switch ((SOCKS6StackLeg)val)
 	{
 	case SOCKS6_STACK_LEG_CLIENT_PROXY:
 	case SOCKS6_STACK_LEG_PROXY_REMOTE:
 	case SOCKS6_STACK_LEG_BOTH:
-		return conv;
+		return true;
 	}
 
-	throw std::invalid_argument("Bad leg");
+	return false;
 }
 
 template <>
-inline SOCKS6AuthReplyCode enumCast<SOCKS6AuthReplyCode>(int val)
+inline bool enumValid<SOCKS6AuthReplyCode>(int val)
 {
-	SOCKS6AuthReplyCode conv = (SOCKS6AuthReplyCode)val;
-
-	switch (conv)
+	switch ((SOCKS6AuthReplyCode)val)
 	{
 	case SOCKS6_AUTH_REPLY_SUCCESS:
 	case SOCKS6_AUTH_REPLY_FAILURE:
-		return conv;
+		return true;
 	}
 
-	throw std::invalid_argument("Bad authentication reply code");
+	return false;
 }
 
 template<>
-inline SOCKS6MPAvailability enumCast<SOCKS6MPAvailability>(int val)
+inline bool enumValid<SOCKS6MPAvailability>(int val)
 {
-	SOCKS6MPAvailability conv = (SOCKS6MPAvailability)val;
-
-	switch (conv)
+	switch ((SOCKS6MPAvailability)val)
 	{
 	case SOCKS6_MP_AVAILABLE:
 	case SOCKS6_MP_UNAVAILABLE:
-		return conv;
+		return true;
 	}
 
-	throw std::invalid_argument("Bad MP availability");
+	return false;
+}
+
+template <typename ENUM>
+inline ENUM enumCast(int val)
+{
+	/* fail if instantiated */
+	switch ((ENUM)val) {}
+}
+
+template <>
+inline SOCKS6StackLeg enumCast<SOCKS6StackLeg>(int val)
+{
+	if (!enumValid<SOCKS6StackLeg>(val))
+		throw std::invalid_argument("Bad leg");
+	return (SOCKS6StackLeg)val;
+}
+
+template <>
+inline SOCKS6AuthReplyCode enumCast<SOCKS6AuthReplyCode>(int val)
+{
+	if (!enumValid<SOCKS6AuthReplyCode>(val))
+		throw std::invalid_argument("Bad authentication reply code");
+	return (SOCKS6AuthReplyCode)val;
+}
+
+template<>
+inline SOCKS6MPAvailability enumCast<SOCKS6MPAvailability>(int val)
+{
+	if (!enumValid<SOCKS6MPAvailability>(val))
+		throw std::invalid_argument("Bad MP availability");
+	return (SOCKS6MPAvailability)val;
 }
 
 #pragma GCC diagnostic pop
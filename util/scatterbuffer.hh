@@ -0,0 +1,181 @@
+#ifndef SOCKS6MSG_SCATTERBUFFER_HH
+#define SOCKS6MSG_SCATTERBUFFER_HH
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "socks6.h"
+#include "exceptions.hh"
+
+namespace S6M
+{
+
+/*
+ * Parses out of an iovec list (e.g. ring segments filled by readv()), with the same tryPeek()/tryGet() interface as ByteBuffer.
+ * Fields that lie within one segment are handed out in place.
+ * Fields that straddle segments are copied into a caller-provided scratch buffer; views parsed from here may point into either,
+ * so both must outlive them.
+ * Copies are plain state: parsers take a copy and assign it back on success, as they do with ByteBuffer.
+ */
+class ScatterBuffer
+{
+	const iovec *iovs;
+	size_t iovCount;
+
+	/* the rest of the current segment; lets the common case look like ByteBuffer */
+	size_t segment = 0;
+	uint8_t *cur = nullptr;
+	uint8_t *end = nullptr;
+
+	size_t used = 0;
+	size_t totalSize = 0;
+
+	uint8_t *scratch;
+	size_t scratchSize;
+	size_t scratchUsed = 0;
+
+	/* skips over exhausted (and empty) segments */
+	void settle() noexcept
+	{
+		while (cur == end && segment + 1 < iovCount)
+		{
+			segment++;
+			cur = reinterpret_cast<uint8_t *>(iovs[segment].iov_base);
+			end = cur + iovs[segment].iov_len;
+		}
+	}
+
+	/* gathers req bytes into scratch; does not move the position */
+	uint8_t *linearize(size_t req) const noexcept
+	{
+		/* keep copies aligned, as they might be read as structures */
+		size_t start = (scratchUsed + 7) & ~(size_t)7;
+		if (start + req > scratchSize)
+			return nullptr;
+
+		uint8_t *dst = scratch + start;
+		size_t copied = end - cur;
+		memcpy(dst, cur, copied);
+		for (size_t seg = segment + 1; copied < req; seg++)
+		{
+			size_t chunk = iovs[seg].iov_len;
+			if (chunk > req - copied)
+				chunk = req - copied;
+			memcpy(dst + copied, iovs[seg].iov_base, chunk);
+			copied += chunk;
+		}
+		return dst;
+	}
+
+	void advance(size_t count) noexcept
+	{
+		used += count;
+		while (count > (size_t)(end - cur))
+		{
+			count -= end - cur;
+			cur = end;
+			settle();
+		}
+		cur += count;
+		settle();
+	}
+
+public:
+	/* enough scratch for any one message, however it is split */
+	static constexpr size_t SCRATCH_SIZE = 1024 + SOCKS6_OPTIONS_LENGTH_MAX;
+
+	ScatterBuffer(const iovec *iovs, size_t iovCount, uint8_t *scratch, size_t scratchSize)
+		: iovs(iovs), iovCount(iovCount), scratch(scratch), scratchSize(scratchSize)
+	{
+		for (size_t i = 0; i < iovCount; i++)
+			totalSize += iovs[i].iov_len;
+		if (iovCount > 0)
+		{
+			cur = reinterpret_cast<uint8_t *>(iovs[0].iov_base);
+			end = cur + iovs[0].iov_len;
+		}
+		settle();
+	}
+
+	size_t getUsed() const
+	{
+		return used;
+	}
+
+	size_t getTotalSize() const
+	{
+		return totalSize;
+	}
+
+	/* how much of the scratch buffer copied fields take up */
+	size_t getScratchUsed() const
+	{
+		return scratchUsed;
+	}
+
+	/* also nullptr if a straddling field does not fit in the scratch buffer */
+	template <typename T>
+	T *tryPeek(size_t count = 1) const noexcept
+	{
+		size_t req = sizeof(T) * count;
+
+		if (req <= (size_t)(end - cur))
+			return reinterpret_cast<T *>(cur);
+		if (req + used > totalSize)
+			return nullptr;
+
+		return reinterpret_cast<T *>(linearize(req));
+	}
+
+	template <typename T>
+	T *tryGet(size_t count = 1) noexcept
+	{
+		size_t req = sizeof(T) * count;
+
+		T *ret = tryPeek<T>(count);
+		if (!ret)
+			return nullptr;
+
+		/* a copy: claim its scratch, so that later copies do not overwrite it */
+		if (reinterpret_cast<uint8_t *>(ret) != cur)
+			scratchUsed = reinterpret_cast<uint8_t *>(ret) - scratch + req;
+
+		advance(req);
+		return ret;
+	}
+
+	/* moves past count bytes without copying any */
+	bool trySkip(size_t count) noexcept
+	{
+		if (count + used > totalSize)
+			return false;
+		advance(count);
+		return true;
+	}
+
+	template <typename T>
+	T *peek(size_t count = 1)
+	{
+		T *ret = tryPeek<T>(count);
+
+		if (!ret)
+			throw EndOfBufferException();
+
+		return ret;
+	}
+
+	template <typename T>
+	T *get(size_t count = 1)
+	{
+		T *ret = tryGet<T>(count);
+
+		if (!ret)
+			throw EndOfBufferException();
+
+		return ret;
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_SCATTERBUFFER_HH
@@ -0,0 +1,247 @@
+#ifndef SOCKS6MSG_SESSIONTABLE_HH
+#define SOCKS6MSG_SESSIONTABLE_HH
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include "optionset.hh"
+#include "optionsetview.hh"
+#include "span.hh"
+
+namespace S6M
+{
+
+/**
+ * @brief Maps session IDs to session state, for servers that issue sessions
+ * Sharded by hash; lookups share their shard's lock and run alongside each other, and allocate nothing.
+ * IDs are compared as SESSION_ID_PREALLOC-byte blocks, so longer ones cannot be stored (issue short IDs).
+ * Sessions end when a request tears them down, or once they have gone unused for the idle timeout.
+ * Stores T *; the table does not own what it points to.
+ */
+template <typename T>
+class SessionTable
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+private:
+	static constexpr size_t WORDS = SESSION_ID_PREALLOC / sizeof(uint64_t);
+
+	/* zero-padded, so that equal IDs are equal blocks */
+	struct Key
+	{
+		uint64_t words[WORDS];
+		size_t   length;
+
+		bool operator ==(const Key &other) const
+		{
+			uint64_t diff = length ^ other.length;
+			for (size_t i = 0; i < WORDS; i++)
+				diff |= words[i] ^ other.words[i];
+			return diff == 0;
+		}
+	};
+
+	struct Hash
+	{
+		size_t operator ()(const Key &key) const
+		{
+			uint64_t hash = key.length;
+			for (size_t i = 0; i < WORDS; i++)
+				hash = (hash ^ key.words[i]) * 0x9e3779b97f4a7c15;
+			return hash ^ (hash >> 32);
+		}
+	};
+
+	struct Entry
+	{
+		T *session;
+		/* Clock ticks; pushed back by lookups, which only hold the lock shared */
+		mutable std::atomic<int64_t> deadline;
+
+		Entry(T *session, int64_t deadline)
+			: session(session), deadline(deadline) {}
+	};
+
+	struct alignas(64) Shard
+	{
+		std::shared_mutex lock;
+		std::unordered_map<Key, Entry, Hash> entries;
+	};
+
+	size_t shardMask;
+	std::unique_ptr<Shard[]> shards;
+	int64_t idleTimeout;
+
+	std::atomic<size_t> count { 0 };
+
+	static bool makeKey(Span<const uint8_t> id, Key *key)
+	{
+		if (id.size() > SESSION_ID_PREALLOC)
+			return false;
+		memset(key->words, 0, sizeof(key->words));
+		memcpy(key->words, id.data(), id.size());
+		key->length = id.size();
+		return true;
+	}
+
+	Shard *shardOf(const Key &key) const
+	{
+		/* the low bits pick the map's bucket; take the high ones */
+		return &shards[(Hash()(key) >> 48) & shardMask];
+	}
+
+	static int64_t ticks(Clock::time_point when)
+	{
+		return when.time_since_epoch().count();
+	}
+
+	static Span<const uint8_t> idOf(const SessionOptionSet &options)
+	{
+		const SessionID *id = options.getID();
+		if (!id)
+			return {};
+		return { id->data(), id->size() };
+	}
+
+	static Span<const uint8_t> idOf(const SessionOptionView &options)
+	{
+		return options.getID();
+	}
+
+public:
+	/* shardCount is rounded up to a power of 2; a few per core keeps writers from getting in each other's way */
+	SessionTable(Clock::duration idleTimeout, size_t shardCount = 64)
+		: idleTimeout(idleTimeout.count())
+	{
+		size_t rounded = 1;
+		while (rounded < shardCount)
+			rounded <<= 1;
+		shardMask = rounded - 1;
+		shards.reset(new Shard[rounded]);
+	}
+
+	SessionTable(const SessionTable &) = delete;
+	SessionTable &operator =(const SessionTable &) = delete;
+
+	/* false if the ID is taken (timed out or not), empty or too long */
+	bool insert(Span<const uint8_t> id, T *session, Clock::time_point now = Clock::now())
+	{
+		Key key;
+		if (id.empty() || !makeKey(id, &key))
+			return false;
+
+		Shard *shard = shardOf(key);
+		std::unique_lock<std::shared_mutex> guard(shard->lock);
+		if (!shard->entries.try_emplace(key, session, ticks(now) + idleTimeout).second)
+			return false;
+		count.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/* nullptr if unknown or timed out; otherwise the session's idle timer starts over */
+	T *find(Span<const uint8_t> id, Clock::time_point now = Clock::now()) const
+	{
+		Key key;
+		if (!makeKey(id, &key))
+			return nullptr;
+
+		Shard *shard = shardOf(key);
+		std::shared_lock<std::shared_mutex> guard(shard->lock);
+		auto it = shard->entries.find(key);
+		if (it == shard->entries.end())
+			return nullptr;
+
+		const Entry *entry = &it->second;
+		int64_t deadline = entry->deadline.load(std::memory_order_relaxed);
+		if (deadline <= ticks(now))
+			return nullptr;
+		/* skip the store (and the cache line bouncing) if the timer was restarted lately */
+		int64_t renewed = ticks(now) + idleTimeout;
+		if (renewed - deadline > idleTimeout / 16)
+			entry->deadline.store(renewed, std::memory_order_relaxed);
+		return entry->session;
+	}
+
+	/* returns what was stored (even if timed out), or nullptr */
+	T *erase(Span<const uint8_t> id)
+	{
+		Key key;
+		if (!makeKey(id, &key))
+			return nullptr;
+
+		Shard *shard = shardOf(key);
+		std::unique_lock<std::shared_mutex> guard(shard->lock);
+		auto it = shard->entries.find(key);
+		if (it == shard->entries.end())
+			return nullptr;
+
+		T *session = it->second.session;
+		shard->entries.erase(it);
+		count.fetch_sub(1, std::memory_order_relaxed);
+		return session;
+	}
+
+	/*
+	 * The session a request's options refer to, if any.
+	 * If the request tears the session down, it is taken out of the table as well; *tornDown tells the caller to finish it off.
+	 * OPTIONS is SessionOptionSet or SessionOptionView.
+	 */
+	template <typename OPTIONS>
+	T *lookup(const OPTIONS &options, bool *tornDown, Clock::time_point now = Clock::now())
+	{
+		*tornDown = false;
+		Span<const uint8_t> id = idOf(options);
+		if (id.empty())
+			return nullptr;
+
+		T *session = find(id, now);
+		if (session && options.tornDown())
+		{
+			*tornDown = erase(id) == session;
+			if (!*tornDown)
+				return nullptr;
+		}
+		return session;
+	}
+
+	/* removes timed-out sessions, handing each to onExpired(T *); returns how many */
+	template <typename CALLBACK>
+	size_t expire(CALLBACK onExpired, Clock::time_point now = Clock::now())
+	{
+		size_t expired = 0;
+		for (size_t i = 0; i <= shardMask; i++)
+		{
+			Shard *shard = &shards[i];
+			std::unique_lock<std::shared_mutex> guard(shard->lock);
+			for (auto it = shard->entries.begin(); it != shard->entries.end();)
+			{
+				if (it->second.deadline.load(std::memory_order_relaxed) > ticks(now))
+				{
+					++it;
+					continue;
+				}
+				onExpired(it->second.session);
+				it = shard->entries.erase(it);
+				expired++;
+			}
+		}
+		count.fetch_sub(expired, std::memory_order_relaxed);
+		return expired;
+	}
+
+	/* timed-out sessions count until expire() gets to them */
+	size_t size() const
+	{
+		return count.load(std::memory_order_relaxed);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_SESSIONTABLE_HH
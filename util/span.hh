@@ -0,0 +1,59 @@
+#ifndef SOCKS6MSG_SPAN_HH
+#define SOCKS6MSG_SPAN_HH
+
+#include <stdint.h>
+#include <unistd.h>
+
+namespace S6M
+{
+
+/**
+ * @brief Non-owning view of a contiguous array
+ * Stand-in for std::span until the library moves past C++17.
+ */
+template <typename T>
+class Span
+{
+	T      *ptr = nullptr;
+	size_t len  = 0;
+
+public:
+	Span() = default;
+
+	Span(T *ptr, size_t len)
+		: ptr(ptr), len(len) {}
+
+	T *data() const
+	{
+		return ptr;
+	}
+
+	size_t size() const
+	{
+		return len;
+	}
+
+	bool empty() const
+	{
+		return len == 0;
+	}
+
+	T *begin() const
+	{
+		return ptr;
+	}
+
+	T *end() const
+	{
+		return ptr + len;
+	}
+
+	T &operator [](size_t i) const
+	{
+		return ptr[i];
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_SPAN_HH
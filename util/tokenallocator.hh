@@ -0,0 +1,135 @@
+#ifndef SOCKS6MSG_TOKENALLOCATOR_HH
+#define SOCKS6MSG_TOKENALLOCATOR_HH
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include "optionset.hh"
+
+namespace S6M
+{
+
+/**
+ * @brief Hands out the tokens of an advertised idempotence window, one per connection attempt
+ * Allocating is a fetch-and-increment and can run on any number of threads at once.
+ * Reseeding (on a new advertisement) is rare and serialized internally;
+ * allocations that race with it retry, and may skip a token of the new window.
+ */
+class IdempotenceTokenAllocator
+{
+	/* seqlock over window and next: odd while a reseed is in */
+	std::atomic<uint32_t> seq { 0 };
+	/* high half: base; low half: size */
+	std::atomic<uint64_t> window { 0 };
+	/* offset of the next token into the window; 64 bits, so it never wraps */
+	std::atomic<uint64_t> next { 0 };
+
+	std::mutex reseedLock;
+
+	std::atomic<uint64_t> accepted { 0 };
+	std::atomic<uint64_t> rejected { 0 };
+
+public:
+	IdempotenceTokenAllocator() = default;
+
+	explicit IdempotenceTokenAllocator(const IdempotenceOptionSet &advertisement)
+	{
+		reseed(advertisement);
+	}
+
+	IdempotenceTokenAllocator(const IdempotenceTokenAllocator &) = delete;
+	IdempotenceTokenAllocator &operator =(const IdempotenceTokenAllocator &) = delete;
+
+	/* starts over on the advertised window; false (and no change) if nothing was advertised */
+	bool reseed(const IdempotenceOptionSet &advertisement)
+	{
+		std::pair<uint32_t, uint32_t> advertised = advertisement.getAdvertised();
+		if (advertised.second == 0)
+			return false;
+
+		std::lock_guard<std::mutex> guard(reseedLock);
+		uint32_t s = seq.load(std::memory_order_relaxed);
+		seq.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		window.store(((uint64_t)advertised.first << 32) | advertised.second, std::memory_order_relaxed);
+		next.store(0, std::memory_order_relaxed);
+
+		seq.store(s + 2, std::memory_order_release);
+		return true;
+	}
+
+	/* nothing once the window is used up (or was never seeded) */
+	std::optional<uint32_t> allocate()
+	{
+		for (;;)
+		{
+			uint32_t s = seq.load(std::memory_order_acquire);
+			if (s & 1)
+				continue;
+
+			uint64_t w = window.load(std::memory_order_relaxed);
+			uint64_t offset = next.fetch_add(1, std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq.load(std::memory_order_relaxed) != s)
+				continue;
+
+			if (offset >= (uint32_t)w)
+				return {};
+			return (uint32_t)(w >> 32) + (uint32_t)offset;
+		}
+	}
+
+	/* allocates and calls setToken(); false if the window is used up */
+	bool assign(IdempotenceOptionSet *request)
+	{
+		std::optional<uint32_t> token = allocate();
+		if (!token)
+			return false;
+		request->setToken(*token);
+		return true;
+	}
+
+	/*
+	 * Tallies the server's verdict on a token from getReply(), and reseeds if the reply advertises a new window.
+	 * Returns the verdict; nothing if the reply carries none.
+	 */
+	std::optional<bool> settle(const IdempotenceOptionSet &reply)
+	{
+		std::optional<bool> verdict = reply.getReply();
+		if (verdict)
+			(*verdict ? accepted : rejected).fetch_add(1, std::memory_order_relaxed);
+		reseed(reply);
+		return verdict;
+	}
+
+	std::pair<uint32_t, uint32_t> getWindow() const
+	{
+		uint64_t w = window.load(std::memory_order_acquire);
+		return { (uint32_t)(w >> 32), (uint32_t)w };
+	}
+
+	/* approximate while allocations are in flight */
+	uint32_t getRemaining() const
+	{
+		uint64_t size = (uint32_t)window.load(std::memory_order_acquire);
+		uint64_t used = next.load(std::memory_order_relaxed);
+		return used >= size ? 0 : size - used;
+	}
+
+	uint64_t getAccepted() const
+	{
+		return accepted.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getRejected() const
+	{
+		return rejected.load(std::memory_order_relaxed);
+	}
+};
+
+}
+
+#endif // SOCKS6MSG_TOKENALLOCATOR_HH
@@ -0,0 +1,82 @@
+#ifndef SOCKS6MSG_TRACEPOINTS_HH
+#define SOCKS6MSG_TRACEPOINTS_HH
+
+/*
+ * Static probes for bpftrace/perf, under the "socks6msg" provider.
+ * Built in with SOCKS6MSG_TRACEPOINTS defined (qmake CONFIG+=tracepoints), which needs <sys/sdt.h>;
+ * code that includes the library's headers must agree on the define, as parsing and packing are partly inline.
+ * A probe is a nop until something attaches to it. Without the define, probes compile to nothing.
+ *
+ * Every probe carries (type, length, result):
+ *   parse_entry   ParseStats::Message, bytes available,                     0
+ *   parse_return  ParseStats::Message, offset reached in the buffer,        ParseResult
+ *   pack_entry    ParseStats::Message, room in the buffer,                  0
+ *   pack_return   ParseStats::Message, bytes packed,                        0 (no return probe if packing threw)
+ *   option        option kind,         option length,                       ParseResult
+ *   capi_entry    TraceCall,           buffer size (0 if there is none),    0
+ *   capi_return   TraceCall,           buffer size (0 if there is none),    return value (0 for void functions)
+ */
+
+#ifdef SOCKS6MSG_TRACEPOINTS
+
+#include <sys/sdt.h>
+
+#define S6M_PROBE(name, type, length, result) \
+	DTRACE_PROBE3(socks6msg, name, (long)(type), (long)(length), (long)(result))
+
+#else
+
+#define S6M_PROBE(name, type, length, result) \
+	do { (void)sizeof((type), (length), (result)); } while (0)
+
+#endif
+
+namespace S6M
+{
+
+/* the C entry points, as told apart by capi_* probes */
+enum TraceCall
+{
+	TC_REQUEST_PACKED_SIZE,
+	TC_REQUEST_PACK,
+	TC_REQUEST_PACK_OR_SIZE,
+	TC_REQUEST_PARSE,
+	TC_REQUEST_PARSE_INTO,
+	TC_REQUEST_PEEK_SIZE,
+	TC_REQUEST_FREE,
+	
+	TC_AUTH_REPLY_PACKED_SIZE,
+	TC_AUTH_REPLY_PACK,
+	TC_AUTH_REPLY_PACK_OR_SIZE,
+	TC_AUTH_REPLY_PARSE,
+	TC_AUTH_REPLY_PARSE_INTO,
+	TC_AUTH_REPLY_PEEK_SIZE,
+	TC_AUTH_REPLY_FREE,
+	
+	TC_OP_REPLY_PACKED_SIZE,
+	TC_OP_REPLY_PACK,
+	TC_OP_REPLY_PACK_OR_SIZE,
+	TC_OP_REPLY_PARSE,
+	TC_OP_REPLY_PARSE_INTO,
+	TC_OP_REPLY_PEEK_SIZE,
+	TC_OP_REPLY_FREE,
+	
+	TC_PASSWD_REQ_PACKED_SIZE,
+	TC_PASSWD_REQ_PACK,
+	TC_PASSWD_REQ_PARSE,
+	TC_PASSWD_REQ_FREE,
+	
+	TC_PASSWD_REPLY_PACKED_SIZE,
+	TC_PASSWD_REPLY_PACK,
+	TC_PASSWD_REPLY_PARSE,
+	TC_PASSWD_REPLY_FREE,
+	
+	TC_STATS_ENABLE,
+	TC_STATS_SNAPSHOT,
+	
+	TC_ERROR_MSG,
+};
+
+}
+
+#endif // SOCKS6MSG_TRACEPOINTS_HH